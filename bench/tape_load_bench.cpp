@@ -0,0 +1,162 @@
+// Tape loader throughput.
+//
+// Writes a synthetic tape of the requested size, loads it with
+// loadTapeText() a few times and reports MB/s for the best run, checking
+// the loaded amounts after every run. Before that, checks that a tape
+// written by writeTapeFile() loads back with the values it was written with.
+//
+// Usage: tape-load-bench [megabytes=100] [runs=3]
+
+#include "calculator_engine.h"
+#include "tape_file.h"
+#include "tape_format.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// A few thousand lines of ordinary adding-machine work: amounts, products,
+// VAT lines, subtotals and totals
+void fillSample(CalculatorEngine& engine) {
+    engine.setDecimalPlaces(2);
+    engine.setVATRate(0.19);
+
+    unsigned seed = 1;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    for (int i = 0; i < 4000; i++) {
+        unsigned amount = next() * 37 % 1000000;
+        for (char digit : std::to_string(amount / 100)) {
+            engine.inputDigit(digit - '0');
+        }
+        engine.inputDecimalPoint();
+        engine.inputDigit(static_cast<int>(amount / 10 % 10));
+        engine.inputDigit(static_cast<int>(amount % 10));
+
+        if (i % 50 == 49) {
+            engine.addVAT();
+            engine.calculateEquals();
+        } else if (i % 10 == 9) {
+            engine.calculateEquals();
+        } else {
+            engine.performOperation(i % 7 == 3 ? '*' : (i % 5 == 2 ? '-' : '+'));
+        }
+    }
+
+    engine.publishSnapshot();
+}
+
+// Whether the loaded tape holds the written entries from `offset` on, with
+// the same amounts up to the decimal places the tape text is written with. The
+// operations are not compared: a line shows the operation that applies to
+// its amount, and loading keeps that one.
+bool sameEntries(const Tape& written, const Tape& loaded, size_t offset, int decimal_places) {
+    if (loaded.size() < offset + written.size()) {
+        std::fprintf(stderr, "Loaded %zu entries, expected at least %zu\n", loaded.size(), offset + written.size());
+        return false;
+    }
+    double half_unit = 0.5 * std::pow(10.0, -decimal_places);
+    for (size_t i = 0; i < written.size(); i++) {
+        TapeEntry expected = written[i];
+        TapeEntry actual = loaded[offset + i];
+        // A VAT line only carries the rate and the VAT amount
+        double wrote = expected.is_vat_operation ? expected.vat_amount : expected.value;
+        double read = actual.is_vat_operation ? actual.vat_amount : actual.value;
+        if (actual.is_separator != expected.is_separator || actual.is_vat_operation != expected.is_vat_operation ||
+            std::abs(read - wrote) > half_unit + std::abs(wrote) * 1e-12) {
+            std::fprintf(stderr, "Entry %zu: wrote %.6f, loaded %.6f\n", offset + i, wrote, read);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Saves the sample with writeTapeFile() and loads it back
+bool checkRoundTrip(const CalculatorEngine& sample, const std::filesystem::path& path) {
+    {
+        std::ofstream out(path, std::ios::binary);
+        writeTapeFile(*sample.snapshot(), [&out](const char* data, size_t size) {
+            out.write(data, static_cast<std::streamsize>(size));
+            return static_cast<bool>(out);
+        });
+        if (!out) {
+            return false;
+        }
+    }
+    CalculatorEngine engine;
+    const Tape& written = sample.getTapeHistory();
+    return loadTapeText(path.string(), engine) && engine.getTapeHistory().size() == written.size() &&
+           sameEntries(written, engine.getTapeHistory(), 0, 2);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+
+    CalculatorEngine sample;
+    fillSample(sample);
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "tape-load-bench.calc.txt";
+    if (!checkRoundTrip(sample, path)) {
+        std::fprintf(stderr, "Saved tape does not load back\n");
+        std::filesystem::remove(path);
+        return 1;
+    }
+
+    std::string block = formatTapeText(*sample.snapshot()) + "\n";
+    size_t bytes = 0;
+    size_t copies = 0;
+    {
+        std::ofstream out(path, std::ios::binary);
+        while (bytes < megabytes * 1024 * 1024) {
+            out << block;
+            bytes += block.size();
+            copies++;
+        }
+        if (!out) {
+            std::fprintf(stderr, "Could not write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::printf("%s: %.1f MB\n", path.c_str(), mb);
+
+    double best = 0.0;
+    size_t entries = 0;
+    for (int run = 0; run < runs; run++) {
+        CalculatorEngine engine;
+        auto start = std::chrono::steady_clock::now();
+        if (!loadTapeText(path.string(), engine)) {
+            std::fprintf(stderr, "Could not load %s\n", path.c_str());
+            return 1;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        entries = engine.getTapeHistory().size();
+
+        // A fast load is only worth reporting if it read the right amounts:
+        // check the first and the last copy of the sample
+        const Tape& written = sample.getTapeHistory();
+        if (entries != copies * written.size() || !sameEntries(written, engine.getTapeHistory(), 0, 2) ||
+            !sameEntries(written, engine.getTapeHistory(), entries - written.size(), 2)) {
+            std::fprintf(stderr, "Loaded %zu entries that do not match the %zu written\n", entries,
+                         copies * written.size());
+            std::filesystem::remove(path);
+            return 1;
+        }
+        std::printf("run %d: %.3f s, %.1f MB/s\n", run + 1, seconds, mb / seconds);
+        best = std::max(best, mb / seconds);
+    }
+    std::printf("%zu entries, best %.1f MB/s\n", entries, best);
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "atomic_file.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+mode_t defaultFileMode() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "Umask:") == 0) {
+            return 0666 & ~static_cast<mode_t>(std::strtoul(line.c_str() + 6, nullptr, 8));
+        }
+    }
+    return 0644;
+}
+
+AtomicFile::AtomicFile(const std::string& path, mode_t new_file_mode)
+    : m_path(path)
+    , m_fd(-1)
+{
+    std::error_code ec;
+    if (std::filesystem::is_symlink(path, ec)) {
+        auto target = std::filesystem::canonical(path, ec);
+        if (!ec) {
+            m_path = target.string();
+        }
+    }
+
+    // Same directory, so the rename cannot cross file systems
+    std::filesystem::path target(m_path);
+    std::string temp = (target.parent_path() / ("." + target.filename().string() + ".XXXXXX")).string();
+    std::vector<char> temp_name(temp.begin(), temp.end());
+    temp_name.push_back('\0');
+    m_fd = ::mkostemp(temp_name.data(), O_CLOEXEC);
+    if (m_fd < 0) {
+        fail("Could not write to: " + m_path);
+        return;
+    }
+    m_temp_path = temp_name.data();
+
+    // mkstemp creates the file private; keep the mode of the file being
+    // replaced, or give a new one the caller's
+    struct stat existing;
+    mode_t mode = new_file_mode;
+    if (::stat(m_path.c_str(), &existing) == 0) {
+        mode = existing.st_mode & 07777;
+    }
+    ::fchmod(m_fd, mode);
+}
+
+AtomicFile::~AtomicFile() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    if (!m_temp_path.empty()) {
+        ::unlink(m_temp_path.c_str());
+    }
+}
+
+bool AtomicFile::write(const char* data, size_t size) {
+    if (!ok()) {
+        return false;
+    }
+    while (size > 0) {
+        ssize_t written = ::write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail("Could not write to: " + m_path);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool AtomicFile::commit() {
+    if (!ok()) {
+        return false;
+    }
+
+    // The data must be on disk before the name points at it, or a crash
+    // could leave an empty file behind the new name
+    if (::fsync(m_fd) != 0) {
+        return fail("Could not write to: " + m_path);
+    }
+    int fd = m_fd;
+    m_fd = -1;
+    if (::close(fd) != 0) {
+        return fail("Could not write to: " + m_path);
+    }
+    if (::rename(m_temp_path.c_str(), m_path.c_str()) != 0) {
+        return fail("Could not replace: " + m_path);
+    }
+    m_temp_path.clear();
+
+    // Make the rename itself durable
+    std::string directory = std::filesystem::path(m_path).parent_path().string();
+    int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+bool AtomicFile::fail(const std::string& what) {
+    if (m_error.empty()) {
+        m_error = what + " (" + std::strerror(errno) + ")";
+    }
+    return false;
+}
@@ -0,0 +1,46 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+// Mode for new files: 0666 less the process umask. The umask is read from
+// /proc/self/status, never set, since setting it affects every thread;
+// 0644 where it cannot be read.
+mode_t defaultFileMode();
+
+// Replaces a file without ever leaving it half written.
+//
+// Data goes to a temporary file in the same directory, which commit()
+// flushes to disk and renames over the target. Until then the old file is
+// untouched; a file that is never committed is removed again. A target
+// that is a symlink is replaced where the link points.
+class AtomicFile {
+public:
+    // new_file_mode is used if path does not exist yet; otherwise the
+    // mode of the file being replaced is kept
+    AtomicFile(const std::string& path, mode_t new_file_mode);
+    ~AtomicFile();  // Removes the temporary file unless committed
+
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    bool ok() const { return m_error.empty(); }
+    const std::string& error() const { return m_error; }
+
+    bool write(const char* data, size_t size);
+
+    // Flushes the data to disk and moves it into place
+    bool commit();
+
+private:
+    bool fail(const std::string& what);
+
+    std::string m_path;       // Target, with symlinks resolved
+    std::string m_temp_path;
+    int m_fd;
+    std::string m_error;
+};
+
+#endif
@@ -1,5 +1,48 @@
 #include "calculator_engine.h"
 #include <cmath>
+#include <cstring>
+
+namespace {
+
+// Fixed-size block at the start of a serialized engine state
+struct StateHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t byte_order;
+    uint32_t input_buffer_size;
+    uint32_t subtotal_text_size;
+    uint32_t reserved;
+    uint64_t payload_size;
+    uint64_t payload_checksum;
+    double running_total;
+    double current_input;
+    double vat_rate;
+    int32_t decimal_places;
+    char pending_operation;
+    uint8_t new_number_started;
+    uint8_t has_decimal_point;
+    uint8_t has_error;
+    uint8_t show_result;
+    uint8_t padding[7];
+};
+
+const char STATE_MAGIC[4] = {'T', 'C', 'E', 'S'};
+const uint16_t STATE_VERSION = 1;
+const uint32_t STATE_BYTE_ORDER = 0x01020304;
+const int MAX_DECIMAL_PLACES = 6;  // Highest setting setDecimalPlaces() accepts
+
+// FNV-1a, to reject truncated or corrupted state files
+uint64_t checksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace
 
 CalculatorEngine::CalculatorEngine()
     : m_running_total(0.0)
@@ -13,7 +56,9 @@ CalculatorEngine::CalculatorEngine()
     , m_has_error(false)
     , m_show_result(false)
     , m_subtotal_text("")
+    , m_snapshot_serial(0)
 {
+    publishSnapshot();
 }
 
 void CalculatorEngine::inputDigit(int digit) {
@@ -245,7 +290,7 @@ void CalculatorEngine::setVATRate(double rate) {
 }
 
 void CalculatorEngine::setDecimalPlaces(int places) {
-    if (places >= 0 && places <= 6) {
+    if (places >= 0 && places <= MAX_DECIMAL_PLACES) {
         m_decimal_places = places;
     }
 }
@@ -319,6 +364,14 @@ void CalculatorEngine::loadTapeEntry(const TapeEntry& entry) {
     m_tape_history.push_back(entry);
 }
 
+void CalculatorEngine::loadTapeEntry(const TapeEntry& entry, uint32_t timestamp) {
+    m_tape_history.push_back(entry, timestamp);
+}
+
+void CalculatorEngine::loadTapeEntries(const std::vector<TapeEntry>& entries, const uint32_t* timestamps) {
+    m_tape_history.append(entries.begin(), entries.end(), timestamps);
+}
+
 void CalculatorEngine::recalculateFromTape() {
     // Reset calculation state
     m_running_total = 0.0;
@@ -376,6 +429,129 @@ void CalculatorEngine::recalculateFromTape() {
     m_new_number_started = true;
 }
 
+void CalculatorEngine::replaceTapeEntries(size_t first, size_t last, const std::vector<TapeEntry>& entries,
+                                          const std::vector<size_t>& sources) {
+    // Replaced lines keep the time they were first entered; new ones are
+    // stamped now. Lines after last keep theirs and are moved, not re-added.
+    std::vector<uint32_t> timestamps;
+    timestamps.reserve(sources.size());
+    for (size_t source : sources) {
+        bool kept = source != SIZE_MAX && source < m_tape_history.size();
+        timestamps.push_back(kept ? m_tape_history.timestampAt(source) : m_tape_history.elapsedMs());
+    }
+    m_tape_history.replace(first, last, entries.begin(), entries.end(), timestamps.data());
+}
+
+void CalculatorEngine::setEditedTotal(double total, char pending_operation, bool show_result) {
+    m_running_total = total;
+    m_pending_operation = pending_operation;
+    m_input_buffer = formatNumber(total);
+    m_new_number_started = true;
+    m_has_decimal_point = false;
+    m_has_error = false;
+    m_show_result = show_result;
+    m_subtotal_text = "";
+}
+
+void CalculatorEngine::publishSnapshot() {
+    // Unchanged tapes are shared with the previous snapshot, so typing
+    // digits never copies the history
+    if (!m_published_tape || m_published_tape->version() != m_tape_history.version()) {
+        m_published_tape = std::make_shared<const Tape>(m_tape_history);
+    }
+
+    auto snap = std::make_shared<EngineSnapshot>();
+    snap->tape = m_published_tape;
+    snap->current_input = getCurrentInput();
+    snap->pending_operation = getRunningTotal();
+    snap->result = getResult();
+    snap->running_total = m_running_total;
+    snap->decimal_places = m_decimal_places;
+    snap->vat_rate = m_vat_rate;
+    snap->new_number_started = m_new_number_started;
+    snap->has_error = m_has_error;
+    snap->show_result = m_show_result;
+    snap->serial = ++m_snapshot_serial;
+
+    m_snapshot.store(std::move(snap), std::memory_order_release);
+}
+
+std::string CalculatorEngine::serializeState() const {
+    // Header first, payload appended in the same buffer, header patched last
+    std::string out(sizeof(StateHeader), '\0');
+    out += m_input_buffer;
+    out += m_subtotal_text;
+    m_tape_history.serialize(out);
+
+    StateHeader header{};
+    std::memcpy(header.magic, STATE_MAGIC, sizeof(header.magic));
+    header.version = STATE_VERSION;
+    header.header_size = sizeof(StateHeader);
+    header.byte_order = STATE_BYTE_ORDER;
+    header.input_buffer_size = static_cast<uint32_t>(m_input_buffer.size());
+    header.subtotal_text_size = static_cast<uint32_t>(m_subtotal_text.size());
+    header.payload_size = out.size() - sizeof(StateHeader);
+    header.payload_checksum = checksum(out.data() + sizeof(StateHeader), header.payload_size);
+    header.running_total = m_running_total;
+    header.current_input = m_current_input;
+    header.vat_rate = m_vat_rate;
+    header.decimal_places = m_decimal_places;
+    header.pending_operation = m_pending_operation;
+    header.new_number_started = m_new_number_started;
+    header.has_decimal_point = m_has_decimal_point;
+    header.has_error = m_has_error;
+    header.show_result = m_show_result;
+    std::memcpy(out.data(), &header, sizeof(StateHeader));
+
+    return out;
+}
+
+bool CalculatorEngine::deserializeState(const char* data, size_t size) {
+    StateHeader header;
+    if (size < sizeof(StateHeader)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(StateHeader));
+
+    if (std::memcmp(header.magic, STATE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != STATE_VERSION ||
+        header.header_size != sizeof(StateHeader) ||
+        header.byte_order != STATE_BYTE_ORDER ||
+        header.payload_size != size - sizeof(StateHeader) ||
+        header.payload_checksum != checksum(data + sizeof(StateHeader), header.payload_size) ||
+        header.input_buffer_size + static_cast<uint64_t>(header.subtotal_text_size) > header.payload_size ||
+        header.decimal_places < 0 || header.decimal_places > MAX_DECIMAL_PLACES) {
+        return false;
+    }
+
+    const char* in = data + sizeof(StateHeader);
+    const char* end = data + size;
+    std::string input_buffer(in, header.input_buffer_size);
+    in += header.input_buffer_size;
+    std::string subtotal_text(in, header.subtotal_text_size);
+    in += header.subtotal_text_size;
+
+    Tape tape;
+    if (!tape.deserialize(in, end) || in != end) {
+        return false;
+    }
+
+    m_tape_history = std::move(tape);
+    m_published_tape.reset();  // Versions of the replaced tape are meaningless now
+    m_input_buffer = std::move(input_buffer);
+    m_subtotal_text = std::move(subtotal_text);
+    m_running_total = header.running_total;
+    m_current_input = header.current_input;
+    m_vat_rate = header.vat_rate;
+    m_decimal_places = header.decimal_places;
+    m_pending_operation = header.pending_operation;
+    m_new_number_started = header.new_number_started != 0;
+    m_has_decimal_point = header.has_decimal_point != 0;
+    m_has_error = header.has_error != 0;
+    m_show_result = header.show_result != 0;
+    return true;
+}
+
 std::string CalculatorEngine::getCurrentInput() const {
     return m_input_buffer;
 }
@@ -416,7 +592,8 @@ void CalculatorEngine::addToTape(double value, char op, bool is_vat) {
         display_text += op;
     }
 
-    m_tape_history.emplace_back(value, op, display_text, is_vat, m_vat_rate);
+    // The tape stamps each new entry with its offset from the session start
+    m_tape_history.push_back(TapeEntry(value, op, display_text, is_vat, m_vat_rate));
 }
 
 std::string CalculatorEngine::formatNumber(double value) const {
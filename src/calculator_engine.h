@@ -1,29 +1,29 @@
 #ifndef CALCULATOR_ENGINE_H
 #define CALCULATOR_ENGINE_H
 
+#include "tape.h"
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iomanip>
 
-struct TapeEntry {
-    double value;
-    char operation;  // '+', '-', '*', '/', '%', 'V', '=', 'S' (separator)
-    std::string display_text;
-    bool is_vat_operation;
-    bool is_separator;
+// Immutable copy of the engine state, published after mutations so that
+// renderers, exporters and printers can read a consistent state without
+// touching the live engine.
+struct EngineSnapshot {
+    std::shared_ptr<const Tape> tape;
+    std::string current_input;
+    std::string pending_operation;  // Same as getRunningTotal()
+    std::string result;             // Same as getResult()
+    double running_total;
+    int decimal_places;
     double vat_rate;
-    double vat_amount;  // For VAT operations
-
-    TapeEntry(double v, char op, const std::string& text, bool vat = false, double rate = 0.0, double vat_amt = 0.0)
-        : value(v), operation(op), display_text(text), is_vat_operation(vat), is_separator(false), vat_rate(rate), vat_amount(vat_amt) {}
-
-    // Constructor for separator
-    static TapeEntry separator() {
-        TapeEntry entry(0.0, 'S', "---------------", false, 0.0, 0.0);
-        entry.is_separator = true;
-        return entry;
-    }
+    bool new_number_started;
+    bool has_error;
+    bool show_result;
+    uint64_t serial;  // Increases with every published snapshot
 };
 
 class CalculatorEngine {
@@ -47,8 +47,17 @@ public:
 
     // Tape loading methods (for Open functionality)
     void loadTapeEntry(const TapeEntry& entry);
+    void loadTapeEntry(const TapeEntry& entry, uint32_t timestamp);
+    void loadTapeEntries(const std::vector<TapeEntry>& entries, const uint32_t* timestamps);
+    void setSessionStart(int64_t unix_ms) { m_tape_history.setSessionStart(unix_ms); }
     void recalculateFromTape();
 
+    // Tape editing: replaces entries [first, last) and keeps the timestamps
+    // of entries whose source index (or SIZE_MAX for new entries) is given
+    void replaceTapeEntries(size_t first, size_t last, const std::vector<TapeEntry>& entries,
+                            const std::vector<size_t>& sources);
+    void setEditedTotal(double total, char pending_operation, bool show_result);
+
     // VAT operations
     void addVAT();
     void subtractVAT();
@@ -64,7 +73,21 @@ public:
     std::string getRunningTotal() const;
     std::string getSubtotal() const;
     std::string getResult() const;
-    const std::vector<TapeEntry>& getTapeHistory() const { return m_tape_history; }
+    const Tape& getTapeHistory() const { return m_tape_history; }
+
+    // A value as the getters above show it, with the current decimal places
+    std::string formatNumber(double value) const;
+
+    // Snapshot publication (RCU style). publishSnapshot() must be called from
+    // the thread that mutates the engine; snapshot() may be called from any
+    // thread and never blocks.
+    void publishSnapshot();
+    std::shared_ptr<const EngineSnapshot> snapshot() const { return m_snapshot.load(std::memory_order_acquire); }
+
+    // Versioned binary form of the complete engine state, including a
+    // half-entered number and a pending operation
+    std::string serializeState() const;
+    bool deserializeState(const char* data, size_t size);
 
     // State queries
     bool hasError() const { return m_has_error; }
@@ -74,7 +97,7 @@ private:
     double m_running_total;
     double m_current_input;
     char m_pending_operation;
-    std::vector<TapeEntry> m_tape_history;
+    Tape m_tape_history;
     int m_decimal_places;
     double m_vat_rate;
     std::string m_input_buffer;
@@ -84,10 +107,14 @@ private:
     bool m_show_result;
     std::string m_subtotal_text;
 
+    // Published state
+    std::atomic<std::shared_ptr<const EngineSnapshot>> m_snapshot;
+    std::shared_ptr<const Tape> m_published_tape;
+    uint64_t m_snapshot_serial;
+
     // Helper methods
     void executeOperation();
     void addToTape(double value, char op, bool is_vat = false);
-    std::string formatNumber(double value) const;
     double parseInput() const;
     void resetInput();
 };
@@ -0,0 +1,119 @@
+#include "consolidation_window.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+ConsolidationWindow::ConsolidationWindow()
+    : m_box(Gtk::Orientation::VERTICAL)
+    , m_total_box(Gtk::Orientation::HORIZONTAL)
+    , m_total_title("Grand total")
+    , m_decimal_places(TapeConsolidation::shared().decimalPlaces())
+{
+    set_title("Consolidated Total");
+    set_default_size(360, 300);
+    set_hide_on_close(true);
+
+    m_list.set_selection_mode(Gtk::SelectionMode::NONE);
+    m_scroll.set_child(m_list);
+    m_scroll.set_vexpand(true);
+    m_scroll.set_policy(Gtk::PolicyType::NEVER, Gtk::PolicyType::AUTOMATIC);
+
+    m_total_title.set_halign(Gtk::Align::START);
+    m_total_title.set_hexpand(true);
+    m_total_amount.set_halign(Gtk::Align::END);
+    m_total_box.set_margin(12);
+    m_total_box.add_css_class("consolidation-total");
+    m_total_box.append(m_total_title);
+    m_total_box.append(m_total_amount);
+
+    m_box.append(m_scroll);
+    m_box.append(*Gtk::make_managed<Gtk::Separator>(Gtk::Orientation::HORIZONTAL));
+    m_box.append(m_total_box);
+    set_child(m_box);
+
+    // Tapes already open, in the order they were opened
+    auto& consolidation = TapeConsolidation::shared();
+    std::vector<TapeConsolidation::Id> ids;
+    for (const auto& [id, source] : consolidation.sources()) {
+        ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (auto id : ids) {
+        add_row(id);
+    }
+    update_grand_total();
+
+    m_subscription = consolidation.subscribe(sigc::mem_fun(*this, &ConsolidationWindow::on_source_changed));
+}
+
+ConsolidationWindow::~ConsolidationWindow() {
+    TapeConsolidation::shared().unsubscribe(m_subscription);
+}
+
+void ConsolidationWindow::on_source_changed(TapeConsolidation::Id id, TapeConsolidation::Change change) {
+    auto& consolidation = TapeConsolidation::shared();
+
+    if (change == TapeConsolidation::Change::ADDED) {
+        add_row(id);
+    } else if (change == TapeConsolidation::Change::REMOVED) {
+        auto it = m_rows.find(id);
+        if (it != m_rows.end()) {
+            m_list.remove(*it->second.row);
+            m_rows.erase(it);
+        }
+    } else if (consolidation.decimalPlaces() != m_decimal_places) {
+        // A preference change reformats every row, once
+        m_decimal_places = consolidation.decimalPlaces();
+        for (const auto& [row_id, row] : m_rows) {
+            update_row(row, *consolidation.find(row_id));
+        }
+    } else {
+        auto it = m_rows.find(id);
+        if (it != m_rows.end()) {
+            update_row(it->second, *consolidation.find(id));
+        }
+    }
+
+    update_grand_total();
+}
+
+void ConsolidationWindow::add_row(TapeConsolidation::Id id) {
+    auto box = Gtk::make_managed<Gtk::Box>(Gtk::Orientation::HORIZONTAL);
+    box->set_margin_start(12);
+    box->set_margin_end(12);
+    box->set_margin_top(4);
+    box->set_margin_bottom(4);
+
+    Row row;
+    row.label = Gtk::make_managed<Gtk::Label>();
+    row.label->set_halign(Gtk::Align::START);
+    row.label->set_hexpand(true);
+    row.label->set_ellipsize(Pango::EllipsizeMode::MIDDLE);
+    row.amount = Gtk::make_managed<Gtk::Label>();
+    row.amount->set_halign(Gtk::Align::END);
+    box->append(*row.label);
+    box->append(*row.amount);
+
+    row.row = Gtk::make_managed<Gtk::ListBoxRow>();
+    row.row->set_child(*box);
+    m_list.append(*row.row);
+
+    update_row(row, *TapeConsolidation::shared().find(id));
+    m_rows.emplace(id, row);
+}
+
+void ConsolidationWindow::update_row(const Row& row, const TapeConsolidation::Source& source) {
+    row.label->set_text(source.label);
+    row.amount->set_text(source.has_error ? "Error" : format_amount(source.total));
+}
+
+void ConsolidationWindow::update_grand_total() {
+    m_total_amount.set_text(format_amount(static_cast<double>(TapeConsolidation::shared().grandTotal())));
+}
+
+std::string ConsolidationWindow::format_amount(double value) const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(m_decimal_places) << value;
+    return oss.str();
+}
@@ -0,0 +1,42 @@
+#ifndef CONSOLIDATION_WINDOW_H
+#define CONSOLIDATION_WINDOW_H
+
+#include "tape_consolidation.h"
+#include <gtkmm.h>
+#include <unordered_map>
+
+// Per-tape totals of every open tape and their grand total.
+//
+// Listens to TapeConsolidation, so a change to one tape rewrites that
+// tape's row and the grand total only.
+class ConsolidationWindow : public Gtk::Window {
+public:
+    ConsolidationWindow();
+    ~ConsolidationWindow() override;
+
+private:
+    struct Row {
+        Gtk::ListBoxRow* row;
+        Gtk::Label* label;
+        Gtk::Label* amount;
+    };
+
+    void on_source_changed(TapeConsolidation::Id id, TapeConsolidation::Change change);
+    void add_row(TapeConsolidation::Id id);
+    void update_row(const Row& row, const TapeConsolidation::Source& source);
+    void update_grand_total();
+    std::string format_amount(double value) const;
+
+    Gtk::Box m_box;
+    Gtk::ScrolledWindow m_scroll;
+    Gtk::ListBox m_list;
+    Gtk::Box m_total_box;
+    Gtk::Label m_total_title;
+    Gtk::Label m_total_amount;
+
+    std::unordered_map<TapeConsolidation::Id, Row> m_rows;
+    int m_decimal_places;  // Places the rows were formatted with
+    uint64_t m_subscription;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "engine_worker.h"
+
+EngineWorker::EngineWorker(CalculatorEngine& engine, std::function<void()> notify)
+    : m_engine(engine)
+    , m_notify(std::move(notify))
+    , m_queue(QUEUE_CAPACITY)
+    , m_submitted_count(0)
+    , m_queued(0)
+    , m_applied(0)
+    , m_notify_pending(false)
+    , m_stop(false)
+{
+    m_thread = std::thread(&EngineWorker::run, this);
+}
+
+EngineWorker::~EngineWorker() {
+    flush();
+    m_stop.store(true, std::memory_order_release);
+    m_queued.fetch_add(1, std::memory_order_release);
+    m_queued.notify_one();
+    m_thread.join();
+}
+
+void EngineWorker::submit(const EngineCommand& command) {
+    m_submitted_count++;
+
+    // Preserve ordering: nothing may overtake commands still in the backlog
+    pump();
+    if (!m_backlog.empty() || !m_queue.push(command)) {
+        m_backlog.push_back(command);
+        return;
+    }
+
+    m_queued.fetch_add(1, std::memory_order_release);
+    m_queued.notify_one();
+}
+
+void EngineWorker::pump() {
+    bool pushed = false;
+    while (!m_backlog.empty() && m_queue.push(m_backlog.front())) {
+        m_backlog.pop_front();
+        pushed = true;
+    }
+
+    if (pushed) {
+        m_queued.fetch_add(1, std::memory_order_release);
+        m_queued.notify_one();
+    }
+}
+
+void EngineWorker::flush() {
+    while (true) {
+        pump();
+        uint64_t applied = m_applied.load(std::memory_order_acquire);
+        if (applied == m_submitted_count) {
+            return;
+        }
+        m_applied.wait(applied, std::memory_order_acquire);
+    }
+}
+
+bool EngineWorker::drained() const {
+    return m_backlog.empty() && m_applied.load(std::memory_order_acquire) == m_submitted_count;
+}
+
+void EngineWorker::acknowledge() {
+    m_notify_pending.store(false, std::memory_order_release);
+    pump();
+}
+
+void EngineWorker::run() {
+    EngineCommand command;
+
+    while (true) {
+        // Read the wake counter before draining so a push that races with
+        // the drain is never missed by the wait below
+        uint64_t seen = m_queued.load(std::memory_order_acquire);
+        if (m_stop.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        uint64_t applied = 0;
+        while (m_queue.pop(command)) {
+            apply(m_engine, command);
+            applied++;
+        }
+
+        if (applied > 0) {
+            // One snapshot and at most one notification per batch
+            m_engine.publishSnapshot();
+            m_applied.fetch_add(applied, std::memory_order_release);
+            m_applied.notify_all();
+
+            if (!m_notify_pending.exchange(true, std::memory_order_acq_rel)) {
+                m_notify();
+            }
+            continue;
+        }
+
+        m_queued.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void EngineWorker::apply(CalculatorEngine& engine, const EngineCommand& command) {
+    switch (command.type) {
+        case EngineCommand::Type::Digit:
+            engine.inputDigit(command.digit);
+            break;
+        case EngineCommand::Type::DecimalPoint:
+            engine.inputDecimalPoint();
+            break;
+        case EngineCommand::Type::Operation:
+            engine.performOperation(command.operation);
+            break;
+        case EngineCommand::Type::Equals:
+            engine.calculateEquals();
+            break;
+        case EngineCommand::Type::Percentage:
+            engine.calculatePercentage();
+            break;
+        case EngineCommand::Type::AddVAT:
+            engine.addVAT();
+            break;
+        case EngineCommand::Type::SubtractVAT:
+            engine.subtractVAT();
+            break;
+        case EngineCommand::Type::Backspace:
+            // If new number hasn't started (just after operation), undo last entry
+            // Otherwise, delete character from input
+            if (engine.isNewNumberStarted() || engine.getCurrentInput() == "0") {
+                engine.undoLastEntry();
+            } else {
+                engine.backspace();
+            }
+            break;
+        case EngineCommand::Type::SetVATRate:
+            engine.setVATRate(command.value);
+            break;
+        case EngineCommand::Type::SetDecimalPlaces:
+            engine.setDecimalPlaces(command.digit);
+            break;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef ENGINE_WORKER_H
+#define ENGINE_WORKER_H
+
+#include "calculator_engine.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+
+// A single keystroke-level engine mutation
+struct EngineCommand {
+    enum class Type : uint8_t {
+        Digit,
+        DecimalPoint,
+        Operation,
+        Equals,
+        Percentage,
+        AddVAT,
+        SubtractVAT,
+        Backspace,  // Deletes a digit, or undoes the last entry after an operation
+        SetVATRate,
+        SetDecimalPlaces,
+    };
+
+    Type type = Type::Digit;
+    char operation = '\0';
+    int digit = 0;
+    double value = 0.0;
+};
+
+// Runs a CalculatorEngine on its own thread.
+//
+// The UI thread is the only producer: it submit()s commands into an SPSC
+// queue and never blocks, even while the engine is busy. The worker applies
+// commands in order, publishes one engine snapshot per drained batch and
+// calls the notify callback at most once until acknowledge() is called, so
+// bursts of keystrokes produce a single UI refresh.
+class EngineWorker {
+public:
+    // notify is invoked on the worker thread and must be thread-safe
+    // (e.g. Glib::Dispatcher::emit)
+    EngineWorker(CalculatorEngine& engine, std::function<void()> notify);
+    ~EngineWorker();
+
+    EngineWorker(const EngineWorker&) = delete;
+    EngineWorker& operator=(const EngineWorker&) = delete;
+
+    // Producer (UI thread) API
+    void submit(const EngineCommand& command);
+    void flush();         // Block until every submitted command has been applied
+    bool drained() const; // True if the engine is idle and may be touched directly
+    void acknowledge();   // Re-arm the notify callback
+
+    // Applies a command directly; used by both the worker and direct mode
+    static void apply(CalculatorEngine& engine, const EngineCommand& command);
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    void run();
+    void pump();
+
+    CalculatorEngine& m_engine;
+    std::function<void()> m_notify;
+    SpscQueue<EngineCommand> m_queue;
+
+    // Producer-only overflow for when the queue is full, so keys are never dropped
+    std::deque<EngineCommand> m_backlog;
+    uint64_t m_submitted_count;
+
+    std::atomic<uint64_t> m_queued;   // Commands pushed into the queue
+    std::atomic<uint64_t> m_applied;  // Commands applied and published
+    std::atomic<bool> m_notify_pending;
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "latency_monitor.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets{}
+    , m_count(0)
+    , m_max_us(0)
+{
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t us) {
+    if (us < SUB_BUCKETS) {
+        return static_cast<size_t>(us);
+    }
+
+    // Keep the top SUB_BUCKET_BITS + 1 bits: the leading one selects the
+    // power of two, the rest the sub-bucket within it
+    int shift = std::bit_width(us) - 1 - SUB_BUCKET_BITS;
+    size_t index = SUB_BUCKETS * (shift + 1) + ((us >> shift) - SUB_BUCKETS);
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    uint64_t sub = index % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+    m_buckets[bucketIndex(value)]++;
+    m_count++;
+    m_max_us = std::max(m_max_us, value);
+}
+
+double LatencyHistogram::percentileMs(double percentile) const {
+    if (m_count == 0) {
+        return 0.0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * (m_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), m_max_us) / 1000.0;
+        }
+    }
+    return maxMs();
+}
+
+LatencyMonitor::KeyScope::KeyScope(LatencyMonitor& monitor)
+    : m_monitor(monitor)
+{
+    m_monitor.m_key_start = std::chrono::steady_clock::now();
+    m_monitor.m_in_key = true;
+}
+
+LatencyMonitor::KeyScope::~KeyScope() {
+    m_monitor.m_in_key = false;
+}
+
+LatencyMonitor::LatencyMonitor()
+    : m_in_key(false)
+{
+}
+
+void LatencyMonitor::inputSubmitted() {
+    if (m_pending.size() == MAX_PENDING) {
+        m_pending.pop_front();
+    }
+    m_pending.push_back({m_in_key ? m_key_start : std::chrono::steady_clock::now(), 0});
+}
+
+void LatencyMonitor::mark(Stage stage) {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    uint8_t bit = static_cast<uint8_t>(1u << static_cast<int>(stage));
+    LatencyHistogram& histogram = m_histograms[static_cast<size_t>(stage)];
+
+    // A stage only counts once the earlier ones have been reached, e.g. a
+    // repaint while the engine thread is still busy does not show the key
+    uint8_t required = static_cast<uint8_t>(bit - 1);
+    for (Sample& sample : m_pending) {
+        if ((sample.reached & required) == required && !(sample.reached & bit)) {
+            sample.reached |= bit;
+            histogram.record(now - sample.start);
+        }
+    }
+
+    // Samples that made it to the screen are complete
+    while (!m_pending.empty() && (m_pending.front().reached & (1u << static_cast<int>(Stage::Frame)))) {
+        m_pending.pop_front();
+    }
+}
+
+std::string LatencyMonitor::summary() const {
+    static const char* const STAGE_NAMES[STAGE_COUNT] = {"engine", "tape", "frame"};
+
+    std::string text = "key to    p50    p95    p99    max  (ms)";
+    char line[128];
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& histogram = m_histograms[i];
+        std::snprintf(line, sizeof(line), "\n%-6s %6.2f %6.2f %6.2f %6.2f  n=%llu", STAGE_NAMES[i],
+                      histogram.percentileMs(50), histogram.percentileMs(95),
+                      histogram.percentileMs(99), histogram.maxMs(),
+                      static_cast<unsigned long long>(histogram.count()));
+        text += line;
+    }
+    return text;
+}
+
+bool LatencyMonitor::appendToFile(const std::string& path) const {
+    if (m_histograms[static_cast<size_t>(Stage::Engine)].count() == 0) {
+        return false;
+    }
+
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (!ec && size > MAX_LOG_BYTES) {
+        std::filesystem::rename(path, path + ".1", ec);
+    }
+
+    std::ofstream file(path, std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::time_t now = std::time(nullptr);
+    char time_buf[64];
+    std::strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    file << "# " << time_buf << "\n" << summary() << "\n\n";
+    return true;
+}
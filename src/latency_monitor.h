@@ -0,0 +1,87 @@
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// Log-linear histogram of durations in microseconds: 16 buckets per power
+// of two, so percentiles are accurate to about 6% at any scale
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::steady_clock::duration duration);
+    uint64_t count() const { return m_count; }
+    double percentileMs(double percentile) const;
+    double maxMs() const { return m_max_us / 1000.0; }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS * 40;
+
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<uint64_t, BUCKET_COUNT> m_buckets;
+    uint64_t m_count;
+    uint64_t m_max_us;
+};
+
+// Measures keystroke latency from the key press to the engine applying it,
+// to update_tape() finishing and to the next frame being painted.
+//
+// Each input opens a pending sample stamped with a monotonic clock; mark()
+// records the elapsed time for every pending sample that has reached the
+// previous stage but not this one, so a burst of keys handled in one frame
+// yields one sample per key. Samples are dropped once they reach the frame
+// stage.
+class LatencyMonitor {
+public:
+    enum class Stage { Engine, Tape, Frame };
+    static constexpr size_t STAGE_COUNT = 3;
+
+    // Marks the start of key handling; the time is used if the key
+    // turns into an engine input before the scope ends
+    class KeyScope {
+    public:
+        explicit KeyScope(LatencyMonitor& monitor);
+        ~KeyScope();
+
+    private:
+        LatencyMonitor& m_monitor;
+    };
+
+    LatencyMonitor();
+
+    void inputSubmitted();  // Opens a sample, starting at the key press if there was one
+    void mark(Stage stage);
+    bool hasPending() const { return !m_pending.empty(); }
+
+    // p50/p95/p99/max per stage, one line each
+    std::string summary() const;
+
+    // Appends the summary to path; does nothing if nothing was measured.
+    // A log past MAX_LOG_BYTES is moved to path.1 first, replacing the
+    // previous one, so at most two logs are kept.
+    bool appendToFile(const std::string& path) const;
+
+private:
+    static constexpr size_t MAX_PENDING = 1024;
+    static constexpr uintmax_t MAX_LOG_BYTES = 256 * 1024;
+
+    struct Sample {
+        std::chrono::steady_clock::time_point start;
+        uint8_t reached;  // Bit per stage
+    };
+
+    std::deque<Sample> m_pending;
+    std::array<LatencyHistogram, STAGE_COUNT> m_histograms;
+    std::chrono::steady_clock::time_point m_key_start;
+    bool m_in_key;
+};
+
+#endif
@@ -19,10 +19,12 @@ int main (int argc, char *argv[]) {
     window->set_hide_on_close(false);
     window->present();
 
-    // Load the first file (if multiple files are passed, only open the first one)
-    if (!files.empty()) {
-      window->load_file(files[0]->get_path());
+    // Every file gets a tab; they are parsed concurrently and shown as each finishes
+    std::vector<std::string> file_paths;
+    for (const auto& file : files) {
+      file_paths.push_back(file->get_path());
     }
+    window->open_files(file_paths);
   });
 
   return app->run(argc, argv);
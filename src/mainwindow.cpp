@@ -13,12 +13,15 @@
 
 MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     : m_app(app)
+    , m_document(nullptr)
     , m_outer_box(Gtk::Orientation::VERTICAL)
     , m_main_box(Gtk::Orientation::HORIZONTAL)
     , m_left_panel(Gtk::Orientation::VERTICAL)
     , m_right_panel(Gtk::Orientation::VERTICAL)
     , m_history_title_box(Gtk::Orientation::HORIZONTAL)
     , m_history_title("Calculation History")
+    , m_search_box(Gtk::Orientation::HORIZONTAL)
+    , m_tape_canvas_box(Gtk::Orientation::HORIZONTAL)
     , m_control_box(Gtk::Orientation::HORIZONTAL)
     , m_vat_box(Gtk::Orientation::HORIZONTAL)
     , m_vat_rate_btn("19%")
@@ -28,13 +31,31 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     , WIDTH(700)
     , HEIGHT(420)
     , m_updating_tape(false)
+    , m_tape_render_valid(false)
+    , m_rendered_lineage(0)
+    , m_rendered_version(0)
+    , m_rendered_count(0)
+    , m_rendered_decimals(-1)
+    , m_tape_follow_end(true)
     , m_tape_edit_mode(false)
-    , m_is_modified(false)
-    , m_current_file_path("")
+    , m_search_current(0)
+    , m_engine_thread_mode(false)
+    , m_tape_canvas_mode(false)
+    , m_latency_logged(false)
+    , m_display_update_pending(false)
+    , m_modified_pending(false)
+    , m_frame_tick_id(0)
+    , m_loading_settings(false)
+    , m_tape_edit_generation(0)
+    , m_tape_edit_evaluation_pending(false)
+    , m_show_next_loaded(false)
 {
     set_title(APPNAME);
     set_default_size(WIDTH, HEIGHT);
 
+    // The first tape exists before anything reads the engine
+    m_document = add_document();
+
     // Setup menu actions
     setup_menu();
 
@@ -63,6 +84,27 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     // Create text tag for red colored text (last value before equals)
     m_tape_buffer->create_tag("red-text")->property_foreground() = "#D86A35";
 
+    // Track which lines are edited, before the buffer applies the change
+    m_tape_buffer->signal_insert().connect(
+        [this](Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int) {
+            if (m_tape_edit_mode && !m_updating_tape) {
+                size_t new_lines = std::count(text.raw().begin(), text.raw().end(), '\n');
+                m_tape_edit_tracker.linesInserted(pos.get_line(), new_lines);
+                queue_tape_edit_evaluation();
+            }
+        }, false);
+    m_tape_buffer->signal_erase().connect(
+        [this](Gtk::TextBuffer::iterator& start, Gtk::TextBuffer::iterator& end) {
+            if (m_tape_edit_mode && !m_updating_tape) {
+                m_tape_edit_tracker.linesErased(start.get_line(), end.get_line());
+                queue_tape_edit_evaluation();
+            }
+        }, false);
+
+    setup_tape_list();
+    setup_tape_canvas();
+    setup_search_bar();
+
     // Configure edit tape button (styled as text link)
     m_edit_tape_button.set_label("EDIT");
     m_edit_tape_button.set_margin_end(15);
@@ -83,6 +125,39 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     m_tape_scroll.set_policy(Gtk::PolicyType::AUTOMATIC, Gtk::PolicyType::AUTOMATIC);
     m_tape_scroll.set_vexpand(true);
 
+    m_tape_stack.add(m_tape_list_scroll, "list");
+    m_tape_stack.add(m_tape_canvas_box, "canvas");
+    m_tape_stack.add(m_tape_scroll, "edit");
+    m_tape_stack.set_visible_child(m_tape_list_scroll);
+    m_tape_stack.set_vexpand(true);
+
+    // Latency overlay in the top right corner of the tape
+    m_latency_label.set_halign(Gtk::Align::END);
+    m_latency_label.set_valign(Gtk::Align::START);
+    m_latency_label.set_margin(6);
+    m_latency_label.add_css_class("latency-overlay");
+    m_latency_label.set_visible(false);
+    // Progress of files opening in the background, along the top of the tape
+    m_open_progress.set_valign(Gtk::Align::START);
+    m_open_progress.set_margin(6);
+    m_open_progress.set_show_text(true);
+    m_open_progress.add_css_class("open-progress");
+    m_open_progress.set_visible(false);
+
+    m_tape_overlay.set_child(m_tape_stack);
+    m_tape_overlay.add_overlay(m_latency_label);
+    m_tape_overlay.add_overlay(m_open_progress);
+    m_tape_overlay.set_vexpand(true);
+
+    // Frames are only painted once the window is realized
+    signal_realize().connect([this]() {
+        m_after_paint_connection = get_frame_clock()->signal_after_paint().connect(
+            sigc::mem_fun(*this, &MainWindow::on_frame_painted));
+    });
+    signal_unrealize().connect([this]() {
+        m_after_paint_connection.disconnect();
+    });
+
     // Configure display labels
     m_running_total_label.set_halign(Gtk::Align::END);
     m_running_total_label.set_margin(5);
@@ -243,7 +318,8 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
 
     // Assemble left panel (history)
     m_left_panel.append(m_history_title_box);
-    m_left_panel.append(m_tape_scroll);
+    m_left_panel.append(m_search_bar);
+    m_left_panel.append(m_tape_overlay);
     m_left_panel.append(m_running_total_label);
     m_left_panel.append(m_subtotal_label);
     m_left_panel.append(m_result_label);
@@ -268,7 +344,14 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     // Fix width but allow height to resize
     m_main_box.set_size_request(WIDTH, -1);
 
+    // Tab strip between the menu bar and the calculator; the pages are empty
+    // placeholders, every tab shares the widgets below
+    m_tabs.set_show_border(false);
+    m_tabs.set_scrollable(true);
+    m_tabs.signal_switch_page().connect(sigc::mem_fun(*this, &MainWindow::on_tab_switched));
+
     // Assemble outer layout with menu bar
+    m_outer_box.append(m_tabs);
     m_outer_box.append(m_main_box);
     m_outer_box.set_spacing(0);
 
@@ -285,130 +368,207 @@ MainWindow::MainWindow(const Glib::RefPtr<Gtk::Application>& app)
     signal_close_request().connect(
         sigc::mem_fun(*this, &MainWindow::on_close_request), false);
 
+    // Quitting does not close windows, so the latency log is written here too
+    m_shutdown_connection = m_app->signal_shutdown().connect(sigc::mem_fun(*this, &MainWindow::write_latency_log));
+
+    // Engine thread notifications arrive on the GTK main loop
+    m_engine_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::on_engine_changed));
+    m_tape_edit_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::on_tape_edit_evaluated));
+    m_pdf_batch_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::on_pdf_batch_finished));
+    m_tape_loader_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::on_tapes_loaded));
+    m_tape_saver_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::on_tapes_saved));
+
     // Load saved settings (VAT rate, decimal places, etc.)
     load_settings();
+    set_engine_thread_mode(m_engine_thread_mode);
+    set_tape_canvas_mode(m_tape_canvas_mode);
 
     // Initial display update
     update_displays();
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    if (m_frame_tick_id != 0) {
+        remove_tick_callback(m_frame_tick_id);
+    }
+    m_after_paint_connection.disconnect();
+    m_open_progress_timer.disconnect();
+    m_shutdown_connection.disconnect();
+    if (m_pdf_batch.valid()) {
+        m_pdf_batch.wait();
+    }
+    write_latency_log();
+}
+
+void MainWindow::write_latency_log() {
+    if (m_latency_logged) {
+        return;
+    }
+    m_latency_logged = true;
+
+    std::string config_path = get_config_path();
+    if (!config_path.empty()) {
+        m_latency.appendToFile(std::filesystem::path(config_path).parent_path().string() + "/latency.log");
+    }
+}
 
 void MainWindow::setup_menu() {
     // Create edit mode action (always enabled)
     auto action_edit_mode = Gio::SimpleAction::create("edit-mode");
     action_edit_mode->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_edit_mode)));
-    m_app->add_action(action_edit_mode);
+    add_action(action_edit_mode);
 
     // Create file actions (always enabled)
     auto action_new = Gio::SimpleAction::create("new");
     action_new->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_new)));
-    m_app->add_action(action_new);
+    add_action(action_new);
 
     auto action_open = Gio::SimpleAction::create("open");
     action_open->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_open)));
-    m_app->add_action(action_open);
+    add_action(action_open);
 
     auto action_save = Gio::SimpleAction::create("save");
     action_save->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_save)));
     action_save->set_enabled(false);  // Initially disabled (no file opened)
-    m_app->add_action(action_save);
+    add_action(action_save);
+    m_action_save = action_save;
 
     auto action_save_as = Gio::SimpleAction::create("save-as");
     action_save_as->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_save_as)));
-    m_app->add_action(action_save_as);
+    add_action(action_save_as);
 
     auto action_save_to_history = Gio::SimpleAction::create("save-to-history");
     action_save_to_history->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_save_to_history)));
     action_save_to_history->set_enabled(false);  // Initially disabled (no calculation yet)
-    m_app->add_action(action_save_to_history);
+    add_action(action_save_to_history);
+    m_action_save_to_history = action_save_to_history;
 
     auto action_print = Gio::SimpleAction::create("print");
     action_print->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_print)));
     action_print->set_enabled(false);  // Initially disabled (no calculation yet)
-    m_app->add_action(action_print);
+    add_action(action_print);
+    m_action_print = action_print;
+
+    auto action_export_pdf = Gio::SimpleAction::create("export-pdf");
+    action_export_pdf->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_export_pdf)));
+    add_action(action_export_pdf);
+
+    auto action_export_history_pdf = Gio::SimpleAction::create("export-history-pdf");
+    action_export_history_pdf->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_export_history_pdf)));
+    add_action(action_export_history_pdf);
+    m_action_export_history_pdf = action_export_history_pdf;
 
     auto action_browse_history = Gio::SimpleAction::create("browse-history");
     action_browse_history->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_browse_history)));
-    m_app->add_action(action_browse_history);
+    add_action(action_browse_history);
+
+    auto action_new_tab = Gio::SimpleAction::create("new-tab");
+    action_new_tab->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_new_tab)));
+    add_action(action_new_tab);
+
+    auto action_close_tab = Gio::SimpleAction::create("close-tab");
+    action_close_tab->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_close_tab)));
+    add_action(action_close_tab);
+
+    auto action_consolidation = Gio::SimpleAction::create("consolidation");
+    action_consolidation->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_consolidation)));
+    add_action(action_consolidation);
 
     auto action_new_window = Gio::SimpleAction::create("new-window");
     action_new_window->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_new_window)));
-    m_app->add_action(action_new_window);
+    add_action(action_new_window);
 
     auto action_quit = Gio::SimpleAction::create("quit");
     action_quit->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_quit)));
-    m_app->add_action(action_quit);
+    add_action(action_quit);
 
     // Create edit actions (initially disabled)
     auto action_cut = Gio::SimpleAction::create("cut");
     action_cut->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_cut)));
     action_cut->set_enabled(false);
-    m_app->add_action(action_cut);
+    add_action(action_cut);
+    m_action_cut = action_cut;
 
     auto action_copy = Gio::SimpleAction::create("copy");
     action_copy->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_copy)));
     action_copy->set_enabled(false);
-    m_app->add_action(action_copy);
+    add_action(action_copy);
+    m_action_copy = action_copy;
 
     auto action_paste = Gio::SimpleAction::create("paste");
     action_paste->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_paste)));
     action_paste->set_enabled(false);
-    m_app->add_action(action_paste);
+    add_action(action_paste);
+    m_action_paste = action_paste;
 
     auto action_select_all = Gio::SimpleAction::create("select-all");
     action_select_all->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_select_all)));
     action_select_all->set_enabled(false);
-    m_app->add_action(action_select_all);
+    add_action(action_select_all);
+    m_action_select_all = action_select_all;
 
     auto action_copy_total = Gio::SimpleAction::create("copy-total");
     action_copy_total->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_copy_total)));
     action_copy_total->set_enabled(false);  // Initially disabled until there's a result
-    m_app->add_action(action_copy_total);
+    add_action(action_copy_total);
+    m_action_copy_total = action_copy_total;
+
+    auto action_find = Gio::SimpleAction::create("find");
+    action_find->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_find)));
+    add_action(action_find);
 
     auto action_documentation = Gio::SimpleAction::create("documentation");
     action_documentation->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_documentation)));
-    m_app->add_action(action_documentation);
+    add_action(action_documentation);
 
     auto action_settings = Gio::SimpleAction::create("settings");
     action_settings->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::on_action_settings)));
-    m_app->add_action(action_settings);
+    add_action(action_settings);
 
     // Set keyboard accelerators
-    m_app->set_accel_for_action("app.edit-mode", "<Primary>e");
-    m_app->set_accel_for_action("app.new", "<Primary>n");
-    m_app->set_accel_for_action("app.open", "<Primary>o");
-    m_app->set_accel_for_action("app.save", "<Primary>s");
-    m_app->set_accel_for_action("app.save-as", "<Primary><Shift>s");
-    m_app->set_accel_for_action("app.new-window", "<Primary><Shift>n");
-    m_app->set_accel_for_action("app.quit", "<Primary>q");
-    m_app->set_accel_for_action("app.cut", "<Primary>x");
-    m_app->set_accel_for_action("app.copy", "<Primary>c");
-    m_app->set_accel_for_action("app.paste", "<Primary>v");
-    m_app->set_accel_for_action("app.select-all", "<Primary>a");
-    m_app->set_accel_for_action("app.copy-total", "<Primary><Shift>c");
-    m_app->set_accel_for_action("app.settings", "<Primary>comma");
-    m_app->set_accel_for_action("app.print", "<Primary>p");
+    m_app->set_accel_for_action("win.edit-mode", "<Primary>e");
+    m_app->set_accel_for_action("win.new", "<Primary>n");
+    m_app->set_accel_for_action("win.open", "<Primary>o");
+    m_app->set_accel_for_action("win.save", "<Primary>s");
+    m_app->set_accel_for_action("win.save-as", "<Primary><Shift>s");
+    m_app->set_accel_for_action("win.new-tab", "<Primary>t");
+    m_app->set_accel_for_action("win.close-tab", "<Primary>w");
+    m_app->set_accel_for_action("win.consolidation", "<Primary><Shift>t");
+    m_app->set_accel_for_action("win.new-window", "<Primary><Shift>n");
+    m_app->set_accel_for_action("win.quit", "<Primary>q");
+    m_app->set_accel_for_action("win.cut", "<Primary>x");
+    m_app->set_accel_for_action("win.copy", "<Primary>c");
+    m_app->set_accel_for_action("win.paste", "<Primary>v");
+    m_app->set_accel_for_action("win.select-all", "<Primary>a");
+    m_app->set_accel_for_action("win.copy-total", "<Primary><Shift>c");
+    m_app->set_accel_for_action("win.settings", "<Primary>comma");
+    m_app->set_accel_for_action("win.print", "<Primary>p");
+    m_app->set_accel_for_action("win.find", "<Primary>f");
 
     // Create menu bar
     auto menu_bar = Gio::Menu::create();
 
     // File menu
     auto file_menu = Gio::Menu::create();
-    file_menu->append("_New", "app.new");
-    file_menu->append("_Open...", "app.open");
+    file_menu->append("_New", "win.new");
+    file_menu->append("_Open...", "win.open");
 
     // Create recent files submenu
     m_recent_files_menu = Gio::Menu::create();
     file_menu->append_submenu("Open _Recent", m_recent_files_menu);
 
-    file_menu->append("_Save", "app.save");
-    file_menu->append("Save _As...", "app.save-as");
-    file_menu->append("Save to _History", "app.save-to-history");
-    file_menu->append("_Print / Save to PDF...", "app.print");
-    file_menu->append("_Browse History...", "app.browse-history");
-    file_menu->append("New _Window", "app.new-window");
-    file_menu->append("_Quit", "app.quit");
+    file_menu->append("_Save", "win.save");
+    file_menu->append("Save _As...", "win.save-as");
+    file_menu->append("Save to _History", "win.save-to-history");
+    file_menu->append("_Print / Save to PDF...", "win.print");
+    file_menu->append("_Export PDF...", "win.export-pdf");
+    file_menu->append("Export History to P_DF", "win.export-history-pdf");
+    file_menu->append("_Browse History...", "win.browse-history");
+    file_menu->append("_Consolidated Total", "win.consolidation");
+    file_menu->append("New _Tab", "win.new-tab");
+    file_menu->append("New _Window", "win.new-window");
+    file_menu->append("_Close Tab", "win.close-tab");
+    file_menu->append("_Quit", "win.quit");
     menu_bar->append_submenu("_File", file_menu);
 
     // Load recent files and populate menu
@@ -417,18 +577,19 @@ void MainWindow::setup_menu() {
 
     // Edit menu
     auto edit_menu = Gio::Menu::create();
-    edit_menu->append("_Edit Mode", "app.edit-mode");
-    edit_menu->append("Cu_t", "app.cut");
-    edit_menu->append("_Copy", "app.copy");
-    edit_menu->append("_Paste", "app.paste");
-    edit_menu->append("Select _All", "app.select-all");
-    edit_menu->append("Copy _Total", "app.copy-total");
-    edit_menu->append("_Settings...", "app.settings");
+    edit_menu->append("_Edit Mode", "win.edit-mode");
+    edit_menu->append("Cu_t", "win.cut");
+    edit_menu->append("_Copy", "win.copy");
+    edit_menu->append("_Paste", "win.paste");
+    edit_menu->append("Select _All", "win.select-all");
+    edit_menu->append("Copy _Total", "win.copy-total");
+    edit_menu->append("_Find...", "win.find");
+    edit_menu->append("_Settings...", "win.settings");
     menu_bar->append_submenu("_Edit", edit_menu);
 
     // Help menu
     auto help_menu = Gio::Menu::create();
-    help_menu->append("_Documentation", "app.documentation");
+    help_menu->append("_Documentation", "win.documentation");
     menu_bar->append_submenu("_Help", help_menu);
 
     // Create menu bar widget
@@ -438,19 +599,20 @@ void MainWindow::setup_menu() {
 
 void MainWindow::update_edit_menu_sensitivity() {
     // Enable/disable edit menu items based on edit mode
-    bool in_edit_mode = m_tape_edit_mode;
-
-    auto action_cut = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("cut"));
-    if (action_cut) action_cut->set_enabled(in_edit_mode);
-
-    auto action_copy = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("copy"));
-    if (action_copy) action_copy->set_enabled(in_edit_mode);
+    if (!m_edit_actions_enabled.update(m_tape_edit_mode)) {
+        return;
+    }
 
-    auto action_paste = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("paste"));
-    if (action_paste) action_paste->set_enabled(in_edit_mode);
+    m_action_cut->set_enabled(m_tape_edit_mode);
+    m_action_copy->set_enabled(m_tape_edit_mode);
+    m_action_paste->set_enabled(m_tape_edit_mode);
+    m_action_select_all->set_enabled(m_tape_edit_mode);
+}
 
-    auto action_select_all = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("select-all"));
-    if (action_select_all) action_select_all->set_enabled(in_edit_mode);
+void MainWindow::set_action_enabled(const Glib::RefPtr<Gio::SimpleAction>& action, Tracked<bool>& state, bool enabled) {
+    if (state.update(enabled)) {
+        action->set_enabled(enabled);
+    }
 }
 
 // Menu action handlers
@@ -490,8 +652,8 @@ void MainWindow::on_action_open() {
 }
 
 void MainWindow::on_action_save() {
-    if (!m_current_file_path.empty()) {
-        save_to_file(m_current_file_path);
+    if (!m_document->file_path.empty()) {
+        save_to_file(m_document->file_path);
     }
 }
 
@@ -506,27 +668,27 @@ void MainWindow::on_action_save_to_history() {
 void MainWindow::on_action_print() {
     auto print_op = Gtk::PrintOperation::create();
 
-    // Set up print settings
-    print_op->set_n_pages(1);
+    // Print from an engine snapshot, not from the text buffer; pending tape
+    // edits are included as for saving
+    sync_engine();
+    auto edited = pending_edit_engine();
+    auto snapshot = edited ? edited->snapshot() : m_document->engine->snapshot();
+    auto job = std::make_shared<TapePrintJob>(snapshot, get_document_title());
     print_op->set_unit(Gtk::Unit::POINTS);
-    print_op->set_job_name("Tape Calculator - " + m_engine.getResult());
-
-    // Connect to the draw_page signal to render the content
-    print_op->signal_draw_page().connect([this](const Glib::RefPtr<Gtk::PrintContext>& context, int page_nr) {
-        auto cr = context->get_cairo_context();
-        auto layout = context->create_pango_layout();
-
-        // Set monospace font
-        auto font_desc = Pango::FontDescription("monospace 12");
-        layout->set_font_description(font_desc);
-
-        // Get tape content
-        std::string tape_content = m_tape_buffer->get_text();
-        layout->set_text(tape_content);
+    print_op->set_job_name("Tape Calculator - " + snapshot->result);
+
+    // Page breaks are computed once the page size is known
+    auto operation = print_op.get();
+    print_op->signal_begin_print().connect([job, operation](const Glib::RefPtr<Gtk::PrintContext>& context) {
+        job->paginate([context]() { return context->create_pango_layout(); },
+                      context->get_width(), context->get_height());
+        operation->set_n_pages(job->pageCount());
+    });
 
-        // Render the text
-        cr->move_to(20, 20);
-        layout->show_in_cairo_context(cr);
+    // Each page is laid out only when it is drawn
+    print_op->signal_draw_page().connect([job](const Glib::RefPtr<Gtk::PrintContext>& context, int page_nr) {
+        job->drawPage(context->get_cairo_context(),
+                      [context]() { return context->create_pango_layout(); }, page_nr);
     });
 
     // Run the print operation
@@ -544,6 +706,70 @@ void MainWindow::on_action_print() {
     }
 }
 
+void MainWindow::on_action_export_pdf() {
+    auto dialog = Gtk::FileDialog::create();
+    dialog->set_title("Export PDF");
+    std::string name = m_document->file_path.empty()
+        ? "tape.pdf"
+        : std::filesystem::path(m_document->file_path).stem().stem().string() + ".pdf";
+    dialog->set_initial_name(name);
+
+    auto filter = Gtk::FileFilter::create();
+    filter->set_name("PDF files");
+    filter->add_pattern("*.pdf");
+    auto filters = Gio::ListStore<Gtk::FileFilter>::create();
+    filters->append(filter);
+    dialog->set_filters(filters);
+
+    // Taken now, so the export shows the tape as it was when chosen;
+    // pending tape edits are included as for printing and saving
+    sync_engine();
+    auto edited = pending_edit_engine();
+    auto snapshot = edited ? edited->snapshot() : m_document->engine->snapshot();
+    dialog->save(*this, [this, snapshot](const Glib::RefPtr<Gio::AsyncResult>& result) {
+        try {
+            auto file = std::dynamic_pointer_cast<Gtk::FileDialog>(result->get_source_object_base())->save_finish(result);
+            if (file && exportTapePdf(snapshot, get_document_title(), file->get_path()) == 0) {
+                auto alert = Gtk::AlertDialog::create("Failed to export PDF");
+                alert->set_detail(file->get_path());
+                alert->show(*this);
+            }
+        } catch (const Glib::Error& err) {
+            // User cancelled
+        }
+    });
+}
+
+void MainWindow::on_action_export_history_pdf() {
+    std::string history_dir = get_history_path();
+    if (history_dir.empty() || m_pdf_batch.valid()) {
+        return;
+    }
+
+    // The batch runs off the main loop; one PDF is written next to each tape
+    m_action_export_history_pdf->set_enabled(false);
+    int decimal_places = m_decimal_places_spin.get_value_as_int();
+    m_pdf_batch = WorkerPool::shared().submit([this, history_dir, decimal_places]() {
+        m_pdf_batch_report = exportTapeFolderPdf(history_dir, decimal_places);
+        m_pdf_batch_dispatcher.emit();
+    });
+}
+
+void MainWindow::on_pdf_batch_finished() {
+    m_pdf_batch.get();
+    m_action_export_history_pdf->set_enabled(true);
+
+    const PdfBatchReport& report = m_pdf_batch_report;
+    std::ostringstream detail;
+    detail << report.tapes - report.failed << " of " << report.tapes << " tapes, "
+           << report.pages << " pages in " << std::fixed << std::setprecision(2) << report.seconds
+           << " s (" << std::setprecision(1) << report.pagesPerSecond() << " pages/s)";
+
+    auto dialog = Gtk::AlertDialog::create("History exported to PDF");
+    dialog->set_detail(detail.str());
+    dialog->show(*this);
+}
+
 void MainWindow::on_action_browse_history() {
     std::string history_dir = get_history_path();
     if (history_dir.empty()) {
@@ -584,6 +810,25 @@ void MainWindow::on_action_new_window() {
     window->present();
 }
 
+void MainWindow::on_action_new_tab() {
+    show_document(add_document());
+}
+
+void MainWindow::on_action_close_tab() {
+    close_document(m_document);
+}
+
+void MainWindow::on_action_consolidation() {
+    // Every window's view lists the tapes of all windows; it hides on close
+    // and goes away with its window
+    if (!m_consolidation_window) {
+        m_consolidation_window = std::make_unique<ConsolidationWindow>();
+        m_consolidation_window->set_transient_for(*this);
+        m_consolidation_window->set_destroy_with_parent(true);
+    }
+    m_consolidation_window->present();
+}
+
 void MainWindow::on_action_quit() {
     m_app->quit();
 }
@@ -616,7 +861,7 @@ void MainWindow::on_action_select_all() {
 
 void MainWindow::on_action_copy_total() {
     // Copy the current result/total to clipboard
-    std::string result = m_engine.getResult();
+    std::string result = m_document->engine->snapshot()->result;
     auto clipboard = get_clipboard();
     clipboard->set_text(result);
 }
@@ -745,10 +990,22 @@ void MainWindow::on_action_settings() {
     history_vbox->append(*history_path_label);
     history_vbox->append(*history_button_box);
 
+    // Engine thread setting
+    auto engine_thread_check = Gtk::make_managed<Gtk::CheckButton>("Run calculations on a background thread");
+    engine_thread_check->set_active(m_engine_thread_mode);
+    engine_thread_check->set_tooltip_text("Keeps typing responsive while long tapes are recalculated");
+
+    // Tape renderer setting
+    auto tape_canvas_check = Gtk::make_managed<Gtk::CheckButton>("Draw the tape with the lightweight renderer");
+    tape_canvas_check->set_active(m_tape_canvas_mode);
+    tape_canvas_check->set_tooltip_text("Draws only the visible lines directly; fastest for very long tapes");
+
     // Add settings to content box
     content_box->append(*vat_box);
     content_box->append(*dec_box);
     content_box->append(*history_vbox);
+    content_box->append(*engine_thread_check);
+    content_box->append(*tape_canvas_check);
 
     // Add separator
     auto separator = Gtk::make_managed<Gtk::Separator>(Gtk::Orientation::HORIZONTAL);
@@ -770,11 +1027,13 @@ void MainWindow::on_action_settings() {
     // OK button
     auto ok_btn = Gtk::make_managed<Gtk::Button>("OK");
     ok_btn->add_css_class("suggested-action");
-    ok_btn->signal_clicked().connect([this, vat_spin, dec_spin, current_history, dialog]() {
+    ok_btn->signal_clicked().connect([this, vat_spin, dec_spin, engine_thread_check, tape_canvas_check, current_history, dialog]() {
         // Apply settings
         m_vat_rate_spin.set_value(vat_spin->get_value());
         m_decimal_places_spin.set_value(dec_spin->get_value_as_int());
         m_custom_history_path = *current_history;
+        set_engine_thread_mode(engine_thread_check->get_active());
+        set_tape_canvas_mode(tape_canvas_check->get_active());
         on_vat_rate_changed();
         on_decimal_places_changed();
         save_settings();
@@ -895,30 +1154,30 @@ void MainWindow::update_recent_files_menu() {
         std::string action_name = "recent-" + std::to_string(i);
 
         // Remove old action if it exists
-        m_app->remove_action(action_name);
+        remove_action(action_name);
 
         // Create action
         auto action = Gio::SimpleAction::create(action_name);
         action->signal_activate().connect([this, file_path](const Glib::VariantBase&) {
             on_action_open_recent(file_path);
         });
-        m_app->add_action(action);
+        add_action(action);
 
         // Add menu item
-        m_recent_files_menu->append(display_name, "app." + action_name);
+        m_recent_files_menu->append(display_name, "win." + action_name);
     }
 
     // Add separator and "Clear List" option
     auto separator_section = Gio::Menu::create();
 
     // Create "Clear List" action if it doesn't exist
-    if (!m_app->lookup_action("clear-recent")) {
+    if (!lookup_action("clear-recent")) {
         auto clear_action = Gio::SimpleAction::create("clear-recent");
         clear_action->signal_activate().connect(sigc::hide(sigc::mem_fun(*this, &MainWindow::clear_recent_files)));
-        m_app->add_action(clear_action);
+        add_action(clear_action);
     }
 
-    separator_section->append("Clear List", "app.clear-recent");
+    separator_section->append("Clear List", "win.clear-recent");
     m_recent_files_menu->append_section("", separator_section);
 }
 
@@ -950,181 +1209,224 @@ void MainWindow::on_action_open_recent(const std::string& file_path) {
 }
 
 void MainWindow::load_file(const std::string& file_path) {
-    // Check if file exists
-    if (!std::filesystem::exists(file_path)) {
-        auto dialog = Gtk::AlertDialog::create("File not found: " + file_path);
-        dialog->show(*this);
-        return;
-    }
-
-    // Read file and parse tape entries
-    std::ifstream infile(file_path);
-    if (!infile.is_open()) {
-        auto dialog = Gtk::AlertDialog::create("Failed to open file: " + file_path);
-        dialog->show(*this);
-        return;
-    }
+    // Parsed in the background; the tape is swapped in once it is complete
+    open_files({file_path});
+}
 
-    // Clear current tape
-    m_engine.clear();
+TapeDocument* MainWindow::add_document() {
+    m_documents.push_back(std::make_unique<TapeDocument>());
+    TapeDocument* document = m_documents.back().get();
+    document->close_button.signal_clicked().connect([this, document]() { close_document(document); });
 
-    // First pass: collect all lines and parse them
-    struct ParsedLine {
-        char operation;
-        double value;
-        bool is_vat;
-        double vat_rate;
-        double vat_amount;
-        bool is_separator;
-    };
-    std::vector<ParsedLine> parsed_lines;
+    m_tabs.append_page(document->page, document->tab);
+    m_tabs.set_tab_reorderable(document->page, true);
+    m_tabs.set_show_tabs(m_documents.size() > 1);
+    update_tab_label(*document);
+    return document;
+}
 
-    std::string line;
-    while (std::getline(infile, line)) {
-        // Skip empty lines
-        if (line.empty()) continue;
+void MainWindow::show_document(TapeDocument* document) {
+    m_tabs.set_current_page(m_tabs.page_num(document->page));
+}
 
-        // Check if it's a separator line
-        if (line.find("---") != std::string::npos) {
-            parsed_lines.push_back({' ', 0.0, false, 0.0, 0.0, true});
-            continue;
+void MainWindow::on_tab_switched(Gtk::Widget* page, guint) {
+    for (auto& document : m_documents) {
+        if (&document->page == page && document.get() != m_document) {
+            switch_document(document.get());
+            return;
         }
+    }
+}
 
-        // Parse operation and value
-        if (line.length() < 3) continue;
+void MainWindow::switch_document(TapeDocument* document) {
+    // Edits are applied to the tape being left
+    if (m_tape_edit_mode) {
+        on_edit_tape_clicked();
+    }
 
-        char operation;
+    // The engine thread only ever serves the shown tape
+    m_engine_worker.reset();
+    m_document = document;
+    m_document->engine->setDecimalPlaces(m_decimal_places_spin.get_value_as_int());
+    m_document->engine->setVATRate(m_vat_rate_spin.get_value() / 100.0);
+    set_engine_thread_mode(m_engine_thread_mode);
 
-        // Check for subtotal (ST)
-        if (line.length() >= 2 && line.substr(0, 2) == "ST") {
-            operation = 'S';
-        } else {
-            operation = line[0];
-        }
+    update_displays();
 
-        // Skip if not a valid operation
-        if (operation != '+' && operation != '-' && operation != '*' &&
-            operation != '/' && operation != '=' && operation != '%' && operation != 'S') {
-            continue;
-        }
+    bool has_tape = !m_document->engine->snapshot()->tape->empty();
+    m_edit_tape_button.set_visible(has_tape);
+    set_action_enabled(m_action_save_to_history, m_save_to_history_enabled, has_tape);
+    set_action_enabled(m_action_print, m_print_enabled, has_tape);
+    set_modified(m_document->modified);
+}
 
-        // Extract the value (right side of the line)
-        std::string value_str;
-        size_t last_space = line.find_last_of(' ');
-        if (last_space != std::string::npos) {
-            value_str = line.substr(last_space + 1);
-        } else {
-            value_str = line.substr(1);
-        }
+void MainWindow::close_document(TapeDocument* document) {
+    if (m_documents.size() == 1) {
+        close();
+        return;
+    }
 
-        // Handle VAT lines (contains % and |)
-        if (line.find('%') != std::string::npos && line.find('|') != std::string::npos) {
-            size_t pipe_pos = line.find('|');
-            size_t percent_pos = line.find('%');
+    if (document->modified) {
+        show_document(document);
+        check_unsaved_changes([this, document]() { remove_document(document); });
+    } else {
+        remove_document(document);
+    }
+}
 
-            std::string vat_rate_str = line.substr(1, percent_pos - 1);
-            std::string vat_amount_str = line.substr(pipe_pos + 1);
+void MainWindow::remove_document(TapeDocument* document) {
+    auto it = std::find_if(m_documents.begin(), m_documents.end(),
+                           [document](const auto& open) { return open.get() == document; });
+    if (it == m_documents.end() || m_documents.size() == 1) {
+        return;
+    }
 
-            // Trim whitespace
-            vat_rate_str.erase(0, vat_rate_str.find_first_not_of(" \t"));
-            vat_rate_str.erase(vat_rate_str.find_last_not_of(" \t") + 1);
-            vat_amount_str.erase(0, vat_amount_str.find_first_not_of(" \t"));
-            vat_amount_str.erase(vat_amount_str.find_last_not_of(" \t") + 1);
+    // Move to a neighbour first so the worker lets go of this engine
+    if (document == m_document) {
+        show_document(it + 1 != m_documents.end() ? (it + 1)->get() : (it - 1)->get());
+    }
+    m_tabs.remove_page(m_tabs.page_num(document->page));
+    m_documents.erase(it);
+    m_tabs.set_show_tabs(m_documents.size() > 1);
+}
 
-            // Parse values
-            std::replace(vat_rate_str.begin(), vat_rate_str.end(), ',', '.');
-            std::replace(vat_amount_str.begin(), vat_amount_str.end(), ',', '.');
+void MainWindow::update_tab_label(TapeDocument& document) {
+    std::string label = document.title().empty() ? "Untitled" : document.title();
+    if (document.modified) {
+        label += "*";
+    }
+    document.tab_label.set_text(label);
+    TapeConsolidation::shared().setLabel(document.consolidation_id,
+                                         document.title().empty() ? "Untitled" : document.title());
+}
 
-            try {
-                double vat_rate = std::stod(vat_rate_str) / 100.0;
-                double vat_amount = std::stod(vat_amount_str);
-                parsed_lines.push_back({operation, vat_amount, true, vat_rate, vat_amount, false});
-            } catch (...) {
-                // Skip invalid VAT line
-            }
-            continue;
+void MainWindow::open_files(const std::vector<std::string>& file_paths) {
+    std::vector<std::string> existing;
+    for (const auto& file_path : file_paths) {
+        if (std::filesystem::exists(file_path)) {
+            existing.push_back(file_path);
+        } else {
+            auto dialog = Gtk::AlertDialog::create("File not found: " + file_path);
+            dialog->show(*this);
         }
+    }
+    if (existing.empty()) {
+        return;
+    }
 
-        // Trim whitespace from value string
-        value_str.erase(0, value_str.find_first_not_of(" \t\r\n"));
-        value_str.erase(value_str.find_last_not_of(" \t\r\n") + 1);
+    if (!m_tape_loader) {
+        m_tape_loader = std::make_unique<TapeLoader>([this]() {
+            m_tape_loader_dispatcher.emit();
+        });
+    }
+    m_show_next_loaded = true;
+    auto loads = m_tape_loader->load(existing, m_decimal_places_spin.get_value_as_int(),
+                                     m_vat_rate_spin.get_value() / 100.0);
+    m_open_loads.insert(m_open_loads.end(), loads.begin(), loads.end());
+
+    // The current tape stays usable; progress is polled while files load
+    if (!m_open_progress_timer.connected()) {
+        m_open_progress_timer = Glib::signal_timeout().connect(
+            sigc::mem_fun(*this, &MainWindow::update_open_progress), 100);
+    }
+    update_open_progress();
+}
 
-        // Parse the number (handle European format: period as thousands separator, comma as decimal)
-        value_str.erase(std::remove(value_str.begin(), value_str.end(), '.'), value_str.end());
-        std::replace(value_str.begin(), value_str.end(), ',', '.');
+bool MainWindow::update_open_progress() {
+    if (m_open_loads.empty()) {
+        m_open_progress.set_visible(false);
+        return false;
+    }
 
-        // Parse using C locale
-        std::istringstream iss(value_str);
-        iss.imbue(std::locale("C"));
-        double value = 0.0;
-        if (iss >> value) {
-            parsed_lines.push_back({operation, value, false, 0.0, 0.0, false});
-        }
+    size_t total = 0;
+    size_t parsed = 0;
+    bool cancelling = false;
+    for (const auto& load : m_open_loads) {
+        total += load->total_bytes;
+        parsed += load->parsed_bytes;
+        cancelling = cancelling || load->cancelled;
     }
 
-    infile.close();
+    std::string text;
+    if (cancelling) {
+        text = "Cancelling...";
+    } else if (m_open_loads.size() == 1) {
+        text = "Opening file... (Esc to cancel)";
+    } else {
+        text = "Opening " + std::to_string(m_open_loads.size()) + " files... (Esc to cancel)";
+    }
+    m_open_progress.set_text(text);
+    m_open_progress.set_fraction(total > 0 ? static_cast<double>(parsed) / total : 0.0);
+    m_open_progress.set_visible(true);
+    return true;
+}
 
-    // Second pass: create tape entries with corrected operations
-    for (size_t i = 0; i < parsed_lines.size(); i++) {
-        const auto& curr = parsed_lines[i];
+void MainWindow::cancel_open() {
+    for (const auto& load : m_open_loads) {
+        load->cancelled = true;
+    }
+    update_open_progress();
+}
 
-        if (curr.is_separator) {
-            m_engine.loadTapeEntry(TapeEntry::separator());
+void MainWindow::on_tapes_loaded() {
+    for (LoadedTape& loaded : m_tape_loader->takeFinished()) {
+        m_open_loads.erase(std::find(m_open_loads.begin(), m_open_loads.end(), loaded.progress));
+        if (loaded.cancelled) {
             continue;
         }
-
-        // Determine the operation to store (the NEXT operation)
-        char next_operation = '\0';
-        if (i + 1 < parsed_lines.size() && !parsed_lines[i + 1].is_separator) {
-            next_operation = parsed_lines[i + 1].operation;
-        } else {
-            next_operation = curr.operation;
+        if (!loaded.engine) {
+            auto dialog = Gtk::AlertDialog::create("Failed to open file: " + loaded.file_path);
+            dialog->show(*this);
+            continue;
         }
 
-        if (curr.is_vat) {
-            char vat_op = (curr.operation == '+') ? 'V' : 'v';
-            TapeEntry entry(curr.value, vat_op, "", true, curr.vat_rate, curr.vat_amount);
-            m_engine.loadTapeEntry(entry);
-        } else if (curr.operation != '=') {
-            TapeEntry entry(curr.value, next_operation, "", false);
-            m_engine.loadTapeEntry(entry);
-        } else {
-            TapeEntry entry(curr.value, '=', "", false);
-            m_engine.loadTapeEntry(entry);
+        // The first tape to finish may take over an untouched blank tab
+        bool reuse = m_show_next_loaded && m_document->blank();
+        TapeDocument* document = reuse ? m_document : add_document();
+        if (reuse) {
+            m_engine_worker.reset();  // Lets go of the engine being replaced
         }
+        document->engine = std::move(loaded.engine);
+        document->file_path = loaded.file_path;
+        document->modified = false;
+        update_tab_label(*document);
+        add_recent_file(loaded.file_path);
+
+        // Tabs loaded in the background still count towards the grand total
+        auto snapshot = document->engine->snapshot();
+        TapeConsolidation::shared().setTotal(document->consolidation_id, snapshot->running_total,
+                                             snapshot->has_error, snapshot->decimal_places);
+
+        if (reuse) {
+            switch_document(document);
+        } else if (m_show_next_loaded) {
+            show_document(document);
+        }
+        m_show_next_loaded = false;
     }
+    update_open_progress();
+}
 
-    // Recalculate from loaded tape
-    m_engine.recalculateFromTape();
-
-    // Update displays
-    update_displays();
-
-    // Show EDIT button
-    m_edit_tape_button.set_visible(true);
-
-    // Enable "Save to History" and "Print" actions after loading file
-    auto action_save_to_history = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("save-to-history"));
-    if (action_save_to_history) action_save_to_history->set_enabled(true);
-
-    auto action_print = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("print"));
-    if (action_print) action_print->set_enabled(true);
-
-    // Add to recent files
-    add_recent_file(file_path);
-
-    // Update file state
-    m_current_file_path = file_path;
-    set_modified(false);
+std::string MainWindow::get_state_path(const std::string& file_path) {
+    return tapeStatePath(file_path);
 }
 
 void MainWindow::setup_css() {
-    m_css_provider = Gtk::CssProvider::create();
-    m_css_provider->load_from_string(R"(
+    // One provider serves every window on the display
+    static Glib::RefPtr<Gtk::CssProvider> css_provider;
+    if (css_provider) {
+        return;
+    }
+    css_provider = Gtk::CssProvider::create();
+    css_provider->load_from_string(R"(
         .history-panel {
             border-right: 1px solid alpha(@borders, 0.3);
         }
 
+        .consolidation-total {
+            font-weight: bold;
+        }
+
         .history-title-box {
             background-color: @theme_base_color;
             padding: 0px;
@@ -1289,6 +1591,64 @@ void MainWindow::setup_css() {
             font-size: 13pt;
         }
 
+        /* Read-only tape rows */
+        listview.tape-list {
+            background: @theme_base_color;
+            padding: 10px 0px;
+        }
+
+        listview.tape-list > row {
+            padding: 0px;
+            min-height: 0px;
+        }
+
+        .tape-row {
+            font-family: monospace;
+            font-size: 13pt;
+            padding: 0px 20px;
+        }
+
+        .tape-row.red-text {
+            color: #D86A35;
+        }
+
+        .tape-row.search-match {
+            background-color: rgba(255, 200, 0, 0.25);
+        }
+
+        .tape-row.search-current {
+            background-color: rgba(255, 200, 0, 0.6);
+        }
+
+        .tape-search-status {
+            font-size: 9pt;
+            margin: 0px 6px;
+        }
+
+        .open-progress {
+            padding: 4px 8px;
+            border-radius: 4px;
+            background: alpha(@theme_base_color, 0.9);
+        }
+
+        .latency-overlay {
+            font-family: monospace;
+            font-size: 9pt;
+            padding: 4px 8px;
+            border-radius: 4px;
+            color: white;
+            background: rgba(0, 0, 0, 0.65);
+        }
+
+        .tape-canvas-box {
+            background: @theme_base_color;
+        }
+
+        .tape-canvas {
+            font-family: monospace;
+            font-size: 13pt;
+        }
+
         /* Compact decimal control */
         spinbutton {
             min-width: 40px;
@@ -1305,7 +1665,7 @@ void MainWindow::setup_css() {
 
     Gtk::StyleContext::add_provider_for_display(
         Gdk::Display::get_default(),
-        m_css_provider,
+        css_provider,
         GTK_STYLE_PROVIDER_PRIORITY_USER);
 }
 
@@ -1325,36 +1685,148 @@ void MainWindow::create_operation_button(const Glib::ustring& label, char op, in
     m_button_grid.attach(*btn, col, row, 1, 1);
 }
 
+void MainWindow::submit_engine_command(const EngineCommand& command) {
+    m_latency.inputSubmitted();
+
+    if (m_engine_worker) {
+        // Never blocks; the display refreshes once the worker has caught up
+        m_engine_worker->submit(command);
+        return;
+    }
+
+    // Apply and publish right away so the snapshot is never stale; the
+    // widgets catch up once per frame
+    EngineWorker::apply(*m_document->engine, command);
+    m_document->engine->publishSnapshot();
+    m_latency.mark(LatencyMonitor::Stage::Engine);
+    queue_display_update();
+}
+
+void MainWindow::queue_display_update() {
+    m_display_update_pending = true;
+    schedule_frame_update();
+}
+
+void MainWindow::queue_modified() {
+    // The flag itself is set now so close/quit checks see it immediately
+    m_document->modified = true;
+    m_document->revision++;
+    m_modified_pending = true;
+    schedule_frame_update();
+}
+
+void MainWindow::schedule_frame_update() {
+    if (m_frame_tick_id != 0) {
+        return;
+    }
+
+    // Not drawn yet, so there is no frame clock to wait for
+    if (!get_mapped()) {
+        flush_frame_update();
+        return;
+    }
+
+    m_frame_tick_id = add_tick_callback([this](const Glib::RefPtr<Gdk::FrameClock>&) {
+        m_frame_tick_id = 0;
+        flush_frame_update();
+        return false;  // One-shot
+    });
+}
+
+void MainWindow::flush_frame_update() {
+    if (m_display_update_pending) {
+        update_displays();
+    }
+    if (m_modified_pending) {
+        m_modified_pending = false;
+        set_modified(m_document->modified);
+    }
+    if (m_tape_edit_evaluation_pending) {
+        submit_tape_edit_evaluation();
+    }
+}
+
+void MainWindow::sync_engine() {
+    if (m_engine_worker) {
+        m_engine_worker->flush();
+    }
+}
+
+void MainWindow::set_engine_thread_mode(bool enabled) {
+    m_engine_thread_mode = enabled;
+
+    if (enabled && !m_engine_worker) {
+        m_engine_worker = std::make_unique<EngineWorker>(*m_document->engine, [this]() {
+            m_engine_dispatcher.emit();
+        });
+    } else if (!enabled && m_engine_worker) {
+        m_engine_worker.reset();  // Flushes pending commands and joins the thread
+        update_displays();
+    }
+}
+
+void MainWindow::on_engine_changed() {
+    if (!m_engine_worker) {
+        return;
+    }
+    m_engine_worker->acknowledge();
+    if (m_engine_worker->drained()) {
+        m_latency.mark(LatencyMonitor::Stage::Engine);
+    }
+    queue_display_update();
+}
+
+void MainWindow::on_frame_painted() {
+    if (!m_latency.hasPending()) {
+        return;
+    }
+
+    m_latency.mark(LatencyMonitor::Stage::Frame);
+    if (m_latency_label.get_visible()) {
+        m_latency_label.set_text(m_latency.summary());
+    }
+}
+
+void MainWindow::toggle_latency_overlay() {
+    bool visible = !m_latency_label.get_visible();
+    if (visible) {
+        m_latency_label.set_text(m_latency.summary());
+    }
+    m_latency_label.set_visible(visible);
+}
+
 void MainWindow::on_number_clicked(int digit) {
-    m_engine.inputDigit(digit);
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::Digit;
+    command.digit = digit;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_operation_clicked(char op) {
-    m_engine.performOperation(op);
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::Operation;
+    command.operation = op;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_equals_clicked() {
-    m_engine.calculateEquals();
-    update_displays();
+    EngineCommand command;
+    command.type = EngineCommand::Type::Equals;
+    submit_engine_command(command);
     m_edit_tape_button.set_visible(true);  // Show EDIT button after calculation
 
     // Enable "Save to History" and "Print" actions after calculation
-    auto action_save_to_history = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("save-to-history"));
-    if (action_save_to_history) action_save_to_history->set_enabled(true);
-
-    auto action_print = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("print"));
-    if (action_print) action_print->set_enabled(true);
+    set_action_enabled(m_action_save_to_history, m_save_to_history_enabled, true);
+    set_action_enabled(m_action_print, m_print_enabled, true);
 
-    set_modified(true);
+    queue_modified();
 }
 
 void MainWindow::on_clear_clicked() {
     // Check if there's work to lose (tape has entries)
-    bool has_work = !m_engine.getTapeHistory().empty();
+    bool has_work = !m_document->engine->snapshot()->tape->empty();
 
     if (has_work) {
         // Show confirmation dialog
@@ -1391,75 +1863,81 @@ void MainWindow::perform_clear() {
         m_edit_tape_button.set_label("EDIT");
         m_edit_tape_button.remove_css_class("active");
         m_tape_view.remove_css_class("edit-mode");
+        show_read_only_tape();
     }
 
-    m_engine.clear();
+    sync_engine();
+    m_document->engine->clear();
     update_displays();
     m_edit_tape_button.set_visible(false);  // Hide EDIT button when cleared
 
     // Disable "Save to History" and "Print" actions when cleared
-    auto action_save_to_history = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("save-to-history"));
-    if (action_save_to_history) action_save_to_history->set_enabled(false);
-
-    auto action_print = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("print"));
-    if (action_print) action_print->set_enabled(false);
+    set_action_enabled(m_action_save_to_history, m_save_to_history_enabled, false);
+    set_action_enabled(m_action_print, m_print_enabled, false);
 
-    m_current_file_path = "";  // Clear current file
+    m_document->file_path = "";  // Clear current file
     set_modified(false);
 }
 
 void MainWindow::on_backspace_clicked() {
-    // If new number hasn't started (just after operation), undo last entry
-    // Otherwise, delete character from input
-    if (m_engine.isNewNumberStarted() || m_engine.getCurrentInput() == "0") {
-        m_engine.undoLastEntry();
-    } else {
-        m_engine.backspace();
-    }
-    update_displays();
-    set_modified(true);
+    // Digit deletion vs. undo is decided by the engine state when applied
+    EngineCommand command;
+    command.type = EngineCommand::Type::Backspace;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_decimal_clicked() {
-    m_engine.inputDecimalPoint();
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::DecimalPoint;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_percent_clicked() {
-    m_engine.calculatePercentage();
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::Percentage;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_add_vat_clicked() {
-    m_engine.addVAT();
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::AddVAT;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_subtract_vat_clicked() {
-    m_engine.subtractVAT();
-    update_displays();
-    set_modified(true);
+    EngineCommand command;
+    command.type = EngineCommand::Type::SubtractVAT;
+    submit_engine_command(command);
+    queue_modified();
 }
 
 void MainWindow::on_vat_rate_changed() {
     // Get VAT rate from spin button (as percentage) and convert to decimal
     double vat_percentage = m_vat_rate_spin.get_value();
-    double vat_rate = vat_percentage / 100.0;
-    m_engine.setVATRate(vat_rate);
+    EngineCommand command;
+    command.type = EngineCommand::Type::SetVATRate;
+    command.value = vat_percentage / 100.0;
+    submit_engine_command(command);
     save_settings();
 }
 
 void MainWindow::on_decimal_places_changed() {
-    int places = m_decimal_places_spin.get_value_as_int();
-    m_engine.setDecimalPlaces(places);
-    update_displays();
+    EngineCommand command;
+    command.type = EngineCommand::Type::SetDecimalPlaces;
+    command.digit = m_decimal_places_spin.get_value_as_int();
+    submit_engine_command(command);
     save_settings();
 }
 
 void MainWindow::on_save_tape_clicked() {
+    save_as(nullptr);
+}
+
+void MainWindow::save_as(std::function<void()> on_saved) {
     // Generate timestamped filename: yymmdd-hhmm.calc.txt
     auto now = std::chrono::system_clock::now();
     auto time_t_now = std::chrono::system_clock::to_time_t(now);
@@ -1482,12 +1960,12 @@ void MainWindow::on_save_tape_clicked() {
     filters->append(filter);
     dialog->set_filters(filters);
 
-    dialog->save(*this, [this](const Glib::RefPtr<Gio::AsyncResult>& result) {
+    dialog->save(*this, [this, on_saved](const Glib::RefPtr<Gio::AsyncResult>& result) {
         try {
             auto file = std::dynamic_pointer_cast<Gtk::FileDialog>(result->get_source_object_base())->save_finish(result);
             if (file) {
                 std::string file_path = file->get_path();
-                save_to_file(file_path);
+                save_to_file(file_path, on_saved);
             }
         } catch (const Gtk::DialogError& err) {
             // User cancelled, ignore
@@ -1498,181 +1976,439 @@ void MainWindow::on_save_tape_clicked() {
 }
 
 void MainWindow::update_displays() {
-    // Update result display - always show running total
-    std::string result = m_engine.getResult();
-    m_result_label.set_text(result);
-    m_result_label.set_visible(true);
+    m_display_update_pending = false;
 
-    // Make result red if negative
-    try {
-        double value = std::stod(result);
-        if (value < 0) {
-            m_result_label.add_css_class("negative-result");
-        } else {
-            m_result_label.remove_css_class("negative-result");
-        }
-    } catch (...) {
-        // If we can't parse (e.g., "Error"), remove the class
-        m_result_label.remove_css_class("negative-result");
+    // Publish the engine state; everything below renders from the snapshot.
+    // While the engine thread is busy it owns the engine and publishes itself.
+    if (!m_engine_worker || m_engine_worker->drained()) {
+        m_document->engine->publishSnapshot();
     }
+    auto snapshot = m_document->engine->snapshot();
+
+    // Update result display - always show running total.
+    // Make result red if negative (taken from the number, not the text)
+    show_result(snapshot->result, !snapshot->has_error && snapshot->running_total < 0);
+
+    // Each tape's total moves the consolidated grand total by its change
+    TapeConsolidation::shared().setTotal(m_document->consolidation_id, snapshot->running_total,
+                                         snapshot->has_error, snapshot->decimal_places);
 
     // Update tape (will show current input as you type)
     update_tape();
 
-    // Update Copy Total action sensitivity - enable when there's a result to copy
-    auto action_copy_total = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("copy-total"));
-    if (action_copy_total) {
-        // Enable if there are tape entries (meaning there's a calculation)
-        bool has_result = !m_engine.getTapeHistory().empty();
-        action_copy_total->set_enabled(has_result);
+    // Update Copy Total action sensitivity - enable when there are tape
+    // entries (meaning there's a calculation)
+    set_action_enabled(m_action_copy_total, m_copy_total_enabled, !snapshot->tape->empty());
+}
+
+void MainWindow::show_result(const std::string& result, bool negative) {
+    // Widgets are only touched when their visible state changed
+    if (m_shown_result.update(result)) {
+        m_result_label.set_text(result);
+        m_result_label.set_visible(true);
+    }
+
+    if (m_shown_negative.update(negative)) {
+        if (negative) {
+            m_result_label.add_css_class("negative-result");
+        } else {
+            m_result_label.remove_css_class("negative-result");
+        }
     }
 }
 
-void MainWindow::update_tape() {
-    m_updating_tape = true;  // Prevent triggering on_tape_changed
+void MainWindow::setup_tape_list() {
+    m_tape_model = TapeListModel::create();
+
+    auto factory = Gtk::SignalListItemFactory::create();
+    factory->signal_setup().connect([](const Glib::RefPtr<Gtk::ListItem>& list_item) {
+        auto label = Gtk::make_managed<Gtk::Label>();
+        label->set_xalign(0.0);
+        label->add_css_class("tape-row");
+        list_item->set_child(*label);
+    });
+
+    // Rows are formatted only when they scroll into view
+    factory->signal_bind().connect([this](const Glib::RefPtr<Gtk::ListItem>& list_item) {
+        auto row = std::dynamic_pointer_cast<TapeRow>(list_item->get_item());
+        auto label = dynamic_cast<Gtk::Label*>(list_item->get_child());
+        if (!row || !label) {
+            return;
+        }
 
-    const auto& history = m_engine.getTapeHistory();
-
-    std::string tape_text;
-    int current_line = 0;
-    std::vector<int> line_starts;  // Track where each line starts in the text
-    std::vector<int> minus_lines;  // Track which lines have minus operations
-    int result_line = -1;  // Track the result line (after separator)
-    double result_value = 0.0;  // Track the result value
-    char previous_operation = '+';  // Default first operation is addition
-
-    for (size_t i = 0; i < history.size(); i++) {
-        const auto& entry = history[i];
-
-        line_starts.push_back(tape_text.length());
-
-        if (entry.is_separator) {
-            tape_text += "---------------\n";
-        } else if (entry.is_vat_operation) {
-            // Format VAT entry: "+    19,00% | 20,88"
-            char op = entry.operation == 'V' ? '+' : '-';
-            std::ostringstream line;
-            line << op << std::right << std::setw(13)
-                 << std::fixed << std::setprecision(0) << (entry.vat_rate * 100)
-                 << "% | " << std::fixed << std::setprecision(m_engine.getDecimalPlaces())
-                 << entry.vat_amount << "\n";
-            tape_text += line.str();
+        TapeLine line = m_tape_model->get_line(row->position());
+        label->set_text(line.text);
+        if (line.highlight) {
+            label->add_css_class("red-text");
         } else {
-            // Format regular entry using PREVIOUS operation (what will be applied to this value)
-            // Exception: result lines use '=' and subtotals use 'ST'
-            std::string display_op;
-            if (entry.operation == '=') {
-                display_op = "=";
-            } else if (entry.operation == 'S') {
-                display_op = "ST";
-            } else {
-                display_op = std::string(1, previous_operation);
-            }
+            label->remove_css_class("red-text");
+        }
+        m_bound_tape_rows[label] = row->position();
+        apply_search_classes(*label, row->position());
+
+        // Show the entry time of a line on hover
+        std::string entered = get_entry_time_text(row->position());
+        if (!entered.empty()) {
+            label->set_tooltip_text(entered);
+        } else {
+            label->set_has_tooltip(false);
+        }
+    });
 
-            std::ostringstream line;
-            std::ostringstream num_str;
-            num_str << std::fixed << std::setprecision(m_engine.getDecimalPlaces()) << entry.value;
+    factory->signal_unbind().connect([this](const Glib::RefPtr<Gtk::ListItem>& list_item) {
+        m_bound_tape_rows.erase(dynamic_cast<Gtk::Label*>(list_item->get_child()));
+    });
 
-            line << std::left << std::setw(2) << display_op << std::right << std::setw(13) << num_str.str() << "\n";
+    m_tape_list.set_model(Gtk::NoSelection::create(m_tape_model));
+    m_tape_list.set_factory(factory);
+    m_tape_list.set_can_focus(false);
 
-            // Track lines with minus operations for red coloring
-            if (entry.operation != '=' && entry.operation != 'S') {
-                if (previous_operation == '-') {
-                    minus_lines.push_back(current_line);
-                }
-                // Update previous operation for next iteration
-                previous_operation = entry.operation;
-            } else if (entry.operation == '=') {
-                // This is the result line
-                result_line = current_line;
-                result_value = entry.value;
-            } else if (entry.operation == 'S') {
-                // This is a subtotal line - track it similarly to result
-                if (entry.value < 0) {
-                    minus_lines.push_back(current_line);
-                }
+    // Clicking a finished calculation expands or collapses it
+    m_tape_list.set_single_click_activate(true);
+    m_tape_list.signal_activate().connect([this](guint position) {
+        m_tape_model->toggle_group(position);
+    });
+    m_tape_list.add_css_class("tape-list");
+
+    m_tape_list_scroll.set_child(m_tape_list);
+    m_tape_list_scroll.set_policy(Gtk::PolicyType::AUTOMATIC, Gtk::PolicyType::AUTOMATIC);
+    m_tape_list_scroll.set_vexpand(true);
+
+    follow_tape_end(m_tape_list_scroll.get_vadjustment());
+}
+
+void MainWindow::setup_tape_canvas() {
+    m_tape_canvas.set_model(m_tape_model);
+    m_tape_canvas.set_hexpand(true);
+    m_tape_canvas.set_vexpand(true);
+
+    // Show the entry time of a line on hover
+    m_tape_canvas.set_has_tooltip(true);
+    m_tape_canvas.signal_query_tooltip().connect(
+        [this](int /*x*/, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip>& tooltip) {
+            int row = m_tape_canvas.get_row_at_y(y);
+            if (keyboard_tooltip || row < 0) {
+                return false;
             }
+            std::string entered = get_entry_time_text(row);
+            if (entered.empty()) {
+                return false;
+            }
+            tooltip->set_text(entered);
+            return true;
+        }, false);
+
+    // Clicking a finished calculation expands or collapses it
+    auto click = Gtk::GestureClick::create();
+    click->signal_released().connect([this](int n_press, double /*x*/, double y) {
+        int row = m_tape_canvas.get_row_at_y(y);
+        if (n_press == 1 && row >= 0) {
+            m_tape_model->toggle_group(static_cast<guint>(row));
+        }
+    });
+    m_tape_canvas.add_controller(click);
+
+    m_tape_canvas_scrollbar.set_orientation(Gtk::Orientation::VERTICAL);
+    m_tape_canvas_scrollbar.set_adjustment(m_tape_canvas.get_vadjustment());
 
-            tape_text += line.str();
+    m_tape_canvas_box.append(m_tape_canvas);
+    m_tape_canvas_box.append(m_tape_canvas_scrollbar);
+    m_tape_canvas_box.add_css_class("tape-canvas-box");
+
+    follow_tape_end(m_tape_canvas.get_vadjustment());
+}
+
+void MainWindow::follow_tape_end(const Glib::RefPtr<Gtk::Adjustment>& vadjustment) {
+    // Stay at the bottom as rows are added, unless the user scrolled away
+    vadjustment->signal_changed().connect([this]() {
+        if (m_tape_follow_end) {
+            scroll_tape_to_end();
         }
-        current_line++;
+    });
+    vadjustment->signal_value_changed().connect([this, vadjustment]() {
+        m_tape_follow_end = vadjustment->get_value() + vadjustment->get_page_size() >= vadjustment->get_upper() - 1.0;
+    });
+}
+
+void MainWindow::scroll_tape_to_end() {
+    // Jumping to the end only lays out the last page of rows
+    auto vadjustment = m_tape_canvas_mode ? m_tape_canvas.get_vadjustment() : m_tape_list_scroll.get_vadjustment();
+    vadjustment->set_value(vadjustment->get_upper() - vadjustment->get_page_size());
+}
+
+void MainWindow::show_read_only_tape() {
+    if (m_tape_canvas_mode) {
+        m_tape_stack.set_visible_child(m_tape_canvas_box);
+    } else {
+        m_tape_stack.set_visible_child(m_tape_list_scroll);
     }
+}
 
-    // Record the end of history entries (before adding pending/current input)
-    int history_end_pos = tape_text.length();
+void MainWindow::set_tape_canvas_mode(bool enabled) {
+    m_tape_canvas_mode = enabled;
+    if (!m_tape_edit_mode) {
+        show_read_only_tape();
+    }
+    m_tape_follow_end = true;
+    scroll_tape_to_end();
+}
 
-    // Add pending operation line if there's a pending operation and user is typing
-    std::string pending_op = m_engine.getRunningTotal();
-    int pending_op_start = -1;
-    if (!pending_op.empty() && m_engine.isNewNumberStarted() && !m_engine.hasError()) {
-        pending_op_start = tape_text.length();
-        tape_text += pending_op + "\n";
+std::string MainWindow::get_entry_time_text(guint position) {
+    if (!m_tape_model->is_history_row(position)) {
+        return "";
     }
 
-    // Add current input if user is actively typing
-    if (!m_engine.isNewNumberStarted() && !m_engine.hasError()) {
-        std::string current_input = m_engine.getCurrentInput();
-        if (!current_input.empty() && current_input != "0") {
-            // Replace dot with comma for display (locale formatting)
-            std::replace(current_input.begin(), current_input.end(), '.', ',');
+    // Collapsed calculations show when their total was entered
+    const Tape& tape = *m_tape_model->get_snapshot()->tape;
+    int64_t unix_ms = tape.sessionStart() + tape.timestampAt(m_tape_model->get_row(position).line);
+    std::time_t entered = static_cast<std::time_t>(unix_ms / 1000);
 
-            // Get the pending operation
-            std::string op = m_engine.getRunningTotal();
-            if (op.empty()) op = " ";
+    char time_buf[64];
+    std::strftime(time_buf, sizeof(time_buf), "Entered %Y-%m-%d %H:%M:%S", std::localtime(&entered));
+    return time_buf;
+}
 
-            // Format: "op     value"
-            std::ostringstream line;
-            line << op << std::right << std::setw(14) << current_input;
-            tape_text += line.str();
-        }
+void MainWindow::update_tape() {
+    m_tape_model->set_snapshot(m_document->engine->snapshot());
+    if (m_search_bar.get_search_mode()) {
+        update_search(false);
+    }
+
+    // Auto-scroll to bottom
+    m_tape_follow_end = true;
+    scroll_tape_to_end();
+
+    // Make sure a frame follows even if nothing visible changed
+    m_latency.mark(LatencyMonitor::Stage::Tape);
+    if (m_latency.hasPending()) {
+        m_tape_stack.queue_draw();
     }
+}
+
+void MainWindow::setup_search_bar() {
+    m_search_entry.set_placeholder_text("149,90  1.000..2.000  VAT  =  ST");
+    m_search_entry.set_hexpand(true);
+    m_search_prev_button.set_icon_name("go-up-symbolic");
+    m_search_prev_button.set_tooltip_text("Previous match (Shift+Ctrl+G)");
+    m_search_next_button.set_icon_name("go-down-symbolic");
+    m_search_next_button.set_tooltip_text("Next match (Ctrl+G)");
+    m_search_status.add_css_class("tape-search-status");
+
+    m_search_box.append(m_search_entry);
+    m_search_box.append(m_search_status);
+    m_search_box.append(m_search_prev_button);
+    m_search_box.append(m_search_next_button);
+    m_search_box.set_spacing(4);
+    m_search_bar.set_child(m_search_box);
+    m_search_bar.connect_entry(m_search_entry);
+    m_search_bar.set_show_close_button(true);
+
+    // search-changed is already debounced by the entry
+    m_search_entry.signal_search_changed().connect([this]() { update_search(true); });
+    m_search_entry.signal_activate().connect([this]() { move_search_match(1); });
+    m_search_entry.signal_next_match().connect([this]() { move_search_match(1); });
+    m_search_entry.signal_previous_match().connect([this]() { move_search_match(-1); });
+    m_search_next_button.signal_clicked().connect([this]() { move_search_match(1); });
+    m_search_prev_button.signal_clicked().connect([this]() { move_search_match(-1); });
+
+    // Closing the bar (Escape or the close button) drops the highlights
+    m_search_bar.property_search_mode_enabled().signal_changed().connect([this]() {
+        if (!m_search_bar.get_search_mode()) {
+            m_search_matches.clear();
+            show_search_matches();
+        }
+    });
+}
+
+void MainWindow::on_action_find() {
+    m_search_bar.set_search_mode(true);
+    m_search_entry.grab_focus();
+    update_search(true);
+}
 
-    m_tape_buffer->set_text(tape_text);
+bool MainWindow::search_has_focus() {
+    Gtk::Widget* focus = get_focus();
+    return focus && (focus == &m_search_entry || focus->is_ancestor(m_search_entry));
+}
 
-    // Apply red/orange color to all lines with minus operations
-    for (int line_num : minus_lines) {
-        if (line_num >= 0 && line_num < (int)line_starts.size()) {
-            int start_pos = line_starts[line_num];
-            int end_pos = (line_num + 1 < (int)line_starts.size())
-                          ? line_starts[line_num + 1] - 1  // -1 to exclude newline
-                          : history_end_pos;
+void MainWindow::update_search(bool jump) {
+    // The index catches up with the tape from the first changed line
+    auto snapshot = m_document->engine->snapshot();
+    m_search_index.update(*snapshot->tape);
+
+    TapeQuery query;
+    std::string text = m_search_entry.get_text();
+    if (parseTapeQuery(text, snapshot->decimal_places, query)) {
+        m_search_matches = m_search_index.find(query);
+    } else {
+        m_search_matches.clear();
+    }
 
-            auto start_iter = m_tape_buffer->get_iter_at_offset(start_pos);
-            auto end_iter = m_tape_buffer->get_iter_at_offset(end_pos);
-            m_tape_buffer->apply_tag_by_name("red-text", start_iter, end_iter);
+    if (m_search_matches.empty()) {
+        m_search_current = 0;
+        m_search_status.set_text(text.empty() ? "" : "No matches");
+    } else {
+        if (jump || m_search_current >= m_search_matches.size()) {
+            m_search_current = 0;
         }
+        m_search_status.set_text(std::to_string(m_search_current + 1) + " of " +
+                                 std::to_string(m_search_matches.size()));
+    }
+
+    show_search_matches();
+    if (jump && !m_search_matches.empty()) {
+        move_search_match(0);
+    }
+}
+
+void MainWindow::move_search_match(int step) {
+    if (m_search_matches.empty()) {
+        return;
     }
 
-    // Apply red/orange color to result line if result is negative
-    if (result_value < 0 && result_line >= 0 && result_line < (int)line_starts.size()) {
-        int start_pos = line_starts[result_line];
-        int end_pos = (result_line + 1 < (int)line_starts.size())
-                      ? line_starts[result_line + 1] - 1
-                      : history_end_pos;
+    size_t count = m_search_matches.size();
+    m_search_current = (m_search_current + count + step % static_cast<int>(count)) % count;
+    m_search_status.set_text(std::to_string(m_search_current + 1) + " of " + std::to_string(count));
+    show_search_matches();
+
+    // Stop following the end of the tape while looking at a match, and open
+    // the calculation it is in
+    m_tape_follow_end = false;
+    guint row = m_tape_model->reveal_line(m_search_matches[m_search_current]);
+    if (m_tape_canvas_mode) {
+        m_tape_canvas.scroll_to_row(row);
+    } else {
+        m_tape_list.scroll_to(row, Gtk::ListScrollFlags::NONE);
+    }
+}
 
-        auto start_iter = m_tape_buffer->get_iter_at_offset(start_pos);
-        auto end_iter = m_tape_buffer->get_iter_at_offset(end_pos);
-        m_tape_buffer->apply_tag_by_name("red-text", start_iter, end_iter);
+void MainWindow::show_search_matches() {
+    // Only rows on screen carry highlight classes; rows scrolled into view
+    // later are marked when they are bound
+    for (const auto& [label, position] : m_bound_tape_rows) {
+        apply_search_classes(*label, position);
     }
+    m_tape_canvas.set_search_matches(m_search_matches, m_search_current);
+}
 
-    // Apply red/orange color to pending operation line (only if it's a minus)
-    if (pending_op_start >= 0 && pending_op == "-") {
-        auto start_iter = m_tape_buffer->get_iter_at_offset(pending_op_start);
-        auto end_iter = m_tape_buffer->get_iter_at_offset(pending_op_start + pending_op.length() + 1);  // "-\n"
-        m_tape_buffer->apply_tag_by_name("red-text", start_iter, end_iter);
+void MainWindow::apply_search_classes(Gtk::Label& label, guint position) {
+    // A collapsed calculation is marked if any of its lines match
+    bool is_match = false;
+    bool is_current = false;
+    if (!m_search_matches.empty() && m_tape_model->is_history_row(position)) {
+        TapeRowRef lines = m_tape_model->get_row(position);
+        auto match = std::lower_bound(m_search_matches.begin(), m_search_matches.end(), lines.first_line);
+        is_match = match != m_search_matches.end() && *match <= lines.line;
+        size_t current = m_search_current < m_search_matches.size() ? m_search_matches[m_search_current] : SIZE_MAX;
+        is_current = is_match && current >= lines.first_line && current <= lines.line;
     }
 
+    if (is_match) {
+        label.add_css_class("search-match");
+    } else {
+        label.remove_css_class("search-match");
+    }
+    if (is_current) {
+        label.add_css_class("search-current");
+    } else {
+        label.remove_css_class("search-current");
+    }
+}
+
+void MainWindow::update_tape_buffer() {
+    m_updating_tape = true;  // Prevent triggering on_tape_changed
+
+    auto snapshot = m_document->engine->snapshot();
+    const Tape& history = *snapshot->tape;
+
+    // The buffer holds one line per history entry followed by the live
+    // pending-operation/input lines. Only entries from the first one that
+    // changed since the last render are rewritten, so a keystroke costs the
+    // same no matter how long the tape is.
+    size_t first_changed = 0;
+    if (m_tape_render_valid &&
+        history.lineage() == m_rendered_lineage &&
+        snapshot->decimal_places == m_rendered_decimals) {
+        first_changed = std::min(history.firstChangedSince(m_rendered_version), m_rendered_count);
+    }
+
+    // Drop the changed history lines and the previous live lines
+    auto iter = m_tape_buffer->erase(m_tape_buffer->get_iter_at_line(static_cast<int>(first_changed)), m_tape_buffer->end());
+
+    // Append the new history lines, batching runs of uncoloured text
+    std::string plain_text;
+    char previous_operation = displayOperationAt(history, first_changed);
+    for (size_t i = first_changed; i < history.size(); i++) {
+        TapeEntry entry = history[i];
+        TapeLine line = formatTapeLine(entry, previous_operation, snapshot->decimal_places);
+        previous_operation = advanceDisplayOperation(previous_operation, entry);
+
+        if (line.highlight) {
+            // Apply red/orange color to lines with minus operations and negative results
+            if (!plain_text.empty()) {
+                iter = m_tape_buffer->insert(iter, plain_text);
+                plain_text.clear();
+            }
+            iter = m_tape_buffer->insert_with_tag(iter, line.text, "red-text");
+            plain_text += "\n";
+        } else {
+            plain_text += line.text;
+            plain_text += "\n";
+        }
+    }
+
+    // Add the pending operation line or the number being typed; only the
+    // pending operation line ends with a newline
+    TapeLine live_line;
+    if (formatLiveLine(*snapshot, live_line)) {
+        std::string live_text = live_line.text + (snapshot->new_number_started ? "\n" : "");
+        if (live_line.highlight) {
+            // Apply red/orange color to pending operation line (only if it's a minus)
+            if (!plain_text.empty()) {
+                iter = m_tape_buffer->insert(iter, plain_text);
+                plain_text.clear();
+            }
+            iter = m_tape_buffer->insert_with_tag(iter, live_text, "red-text");
+        } else {
+            plain_text += live_text;
+        }
+    }
+
+    if (!plain_text.empty()) {
+        m_tape_buffer->insert(iter, plain_text);
+    }
+
+    m_rendered_lineage = history.lineage();
+    m_rendered_version = history.version();
+    m_rendered_count = history.size();
+    m_rendered_decimals = snapshot->decimal_places;
+    m_tape_render_valid = true;
+
     // Auto-scroll to bottom
-    auto mark = m_tape_buffer->create_mark(m_tape_buffer->end());
-    m_tape_view.scroll_to(mark);
+    if (!m_tape_end_mark) {
+        m_tape_end_mark = m_tape_buffer->create_mark("tape-end", m_tape_buffer->end(), false);
+    }
+    m_tape_buffer->move_mark(m_tape_end_mark, m_tape_buffer->end());
+    m_tape_view.scroll_to(m_tape_end_mark);
 
     m_updating_tape = false;  // Re-enable on_tape_changed
 }
 
 void MainWindow::on_edit_tape_clicked() {
     if (!m_tape_edit_mode) {
-        // Enter edit mode
+        // Enter edit mode: bring the text buffer up to date and show it.
+        // Once edited, the buffer no longer mirrors the rendered tape.
+        update_tape_buffer();
+        m_tape_edit_tracker.reset();
+        m_tape_edit_generation++;
+        if (!m_tape_edit_worker) {
+            m_tape_edit_worker = std::make_unique<TapeEditWorker>([this]() {
+                m_tape_edit_dispatcher.emit();
+            });
+        }
+        m_tape_stack.set_visible_child(m_tape_scroll);
         m_tape_edit_mode = true;
+        m_tape_render_valid = false;
         m_tape_view.set_editable(true);
         m_tape_view.set_cursor_visible(true);
         m_tape_view.set_can_focus(true);
@@ -1695,129 +2431,163 @@ void MainWindow::on_edit_tape_clicked() {
         // Remove visual feedback
         m_edit_tape_button.remove_css_class("active");
         m_tape_view.remove_css_class("edit-mode");
+        show_read_only_tape();
 
         // Update menu sensitivity
         update_edit_menu_sensitivity();
 
-        // Parse the edited tape and recalculate everything
-        std::string tape_text = m_tape_buffer->get_text();
-        std::istringstream stream(tape_text);
-        std::string line;
-
-        // Clear the calculator engine
-        m_engine.clear();
-
-        std::vector<double> values;
-        std::vector<char> operations;
+        // Re-evaluate only the lines changed while editing
+        if (m_tape_edit_tracker.dirty()) {
+            apply_tape_edit();
+        }
+    }
+}
 
-        // Parse each line
-        while (std::getline(stream, line)) {
-            // Skip empty lines, separator lines, and result lines
-            if (line.empty() || line.find("---") != std::string::npos) {
-                continue;
-            }
+TapeEditRequest MainWindow::build_tape_edit_request(const EngineSnapshot& snapshot) {
+    TapeEditRequest request;
+    request.tape = snapshot.tape;
+    request.decimal_places = snapshot.decimal_places;
+    request.line_shift = m_tape_edit_tracker.lineShift();
+
+    int line_count = m_tape_buffer->get_line_count();
+    int first_line = static_cast<int>(m_tape_edit_tracker.firstDirtyLine());
+    int last_line = static_cast<int>(m_tape_edit_tracker.lastDirtyLine());
+    first_line = std::min(first_line, line_count - 1);
+    last_line = std::min(last_line, line_count - 1);
+    request.first_line = first_line;
+    for (int line = first_line; line <= last_line; line++) {
+        request.lines.push_back(get_tape_buffer_line(line));
+    }
 
-            if (line.size() >= 2 && line[0] == '=') {
-                break;  // Stop at result line
-            }
+    // The number being typed is part of the tape text too
+    std::ptrdiff_t live_line = static_cast<std::ptrdiff_t>(snapshot.tape->size()) + request.line_shift;
+    if (live_line > last_line && live_line < line_count) {
+        request.live_line = get_tape_buffer_line(static_cast<int>(live_line));
+    }
+    return request;
+}
 
-            // Parse operation and value
-            if (line.size() >= 2 && (line[0] == '+' || line[0] == '-' || line[0] == '*' || line[0] == '/')) {
-                char op = line[0];
+void MainWindow::apply_tape_edit() {
+    sync_engine();
+    m_document->engine->publishSnapshot();
+    TapeEditResult result = evaluateTapeEdit(build_tape_edit_request(*m_document->engine->snapshot()));
 
-                // Extract numeric value
-                std::string value_str = line.substr(1);
+    m_document->engine->replaceTapeEntries(result.first_entry, result.old_entry_end, result.entries, result.sources);
+    if (result.reached_end) {
+        m_document->engine->setEditedTotal(result.running_total, result.pending_operation, result.show_result);
+    }
+    m_tape_edit_tracker.reset();
+    m_tape_edit_generation++;  // Live results still in flight are stale now
 
-                // Skip VAT lines
-                if (value_str.find('|') != std::string::npos) {
-                    continue;
-                }
+    update_displays();
+    m_document->revision++;
+    set_modified(true);  // Mark as modified after editing
+}
 
-                // Trim whitespace
-                size_t start = value_str.find_first_not_of(" \t");
-                if (start != std::string::npos) {
-                    value_str = value_str.substr(start);
-                }
+std::unique_ptr<CalculatorEngine> MainWindow::pending_edit_engine() {
+    if (!m_tape_edit_mode || !m_tape_edit_tracker.dirty()) {
+        return nullptr;
+    }
 
-                size_t end = value_str.find_last_not_of(" \t\r\n");
-                if (end != std::string::npos) {
-                    value_str = value_str.substr(0, end + 1);
-                }
+    // Same steps as apply_tape_edit(), on a copy restored from the state
+    // (which carries the timestamps and session start too)
+    sync_engine();
+    std::string state = m_document->engine->serializeState();
+    auto engine = std::make_unique<CalculatorEngine>();
+    if (!engine->deserializeState(state.data(), state.size())) {
+        return nullptr;
+    }
+    engine->publishSnapshot();
+    TapeEditResult result = evaluateTapeEdit(build_tape_edit_request(*engine->snapshot()));
+    engine->replaceTapeEntries(result.first_entry, result.old_entry_end, result.entries, result.sources);
+    if (result.reached_end) {
+        engine->setEditedTotal(result.running_total, result.pending_operation, result.show_result);
+    }
+    engine->publishSnapshot();
+    return engine;
+}
 
-                // Parse the number (handle European format: period as thousands separator, comma as decimal)
-                // First remove all periods (thousands separators)
-                value_str.erase(std::remove(value_str.begin(), value_str.end(), '.'), value_str.end());
-                // Then replace comma with period (decimal separator for C locale)
-                std::replace(value_str.begin(), value_str.end(), ',', '.');
-
-                // Parse using C locale to ensure '.' is recognized as decimal separator
-                std::istringstream iss(value_str);
-                iss.imbue(std::locale("C"));
-                double value = 0.0;
-                if (iss >> value) {
-                    values.push_back(value);
-                    operations.push_back(op);
-                } else {
-                    continue;
-                }
-            }
-        }
+void MainWindow::queue_tape_edit_evaluation() {
+    m_tape_edit_generation++;
+    m_tape_edit_evaluation_pending = true;
+    schedule_frame_update();
+}
 
-        // Rebuild calculation using the engine
-        if (!values.empty()) {
-            std::ostringstream oss;
-            oss.imbue(std::locale("C"));  // Use C locale to ensure '.' as decimal separator
+void MainWindow::submit_tape_edit_evaluation() {
+    m_tape_edit_evaluation_pending = false;
+    if (!m_tape_edit_mode || !m_tape_edit_worker || !m_tape_edit_tracker.dirty()) {
+        return;
+    }
 
-            // Handle first value
-            // If first operation is '-', we need to subtract from 0
-            if (operations[0] == '-') {
-                // Input 0, then subtract the first value
-                m_engine.inputDigit(0);
-                m_engine.performOperation('-');
-            }
+    // Typing only touches the buffer; the engine is updated on DONE
+    sync_engine();
+    m_tape_edit_worker->submit(build_tape_edit_request(*m_document->engine->snapshot()), m_tape_edit_generation);
+}
 
-            // Input first value with proper formatting
-            oss << std::fixed << std::setprecision(m_engine.getDecimalPlaces()) << values[0];
-            std::string val_str = oss.str();
-            for (char c : val_str) {
-                if (c == '.') {
-                    m_engine.inputDecimalPoint();
-                } else if (c >= '0' && c <= '9') {
-                    m_engine.inputDigit(c - '0');
-                }
-            }
+void MainWindow::on_tape_edit_evaluated() {
+    TapeEditResult result;
+    uint64_t generation = 0;
+    if (!m_tape_edit_worker || !m_tape_edit_worker->takeResult(result, generation)) {
+        return;
+    }
 
-            // Apply operations with subsequent values
-            // Loop through all values except the last one
-            for (size_t i = 0; i < values.size() - 1; i++) {
-                m_engine.performOperation(operations[i + 1]);
-
-                // Input next value
-                oss.str("");
-                oss.clear();
-                oss << std::fixed << std::setprecision(m_engine.getDecimalPlaces()) << values[i + 1];
-                val_str = oss.str();
-
-                for (char c : val_str) {
-                    if (c == '.') {
-                        m_engine.inputDecimalPoint();
-                    } else if (c >= '0' && c <= '9') {
-                        m_engine.inputDigit(c - '0');
-                    }
-                }
-            }
+    // Line numbers of an older result no longer match the buffer
+    if (!m_tape_edit_mode || generation != m_tape_edit_generation) {
+        return;
+    }
 
-            // Calculate final result
-            m_engine.calculateEquals();
+    // Refresh result and subtotal lines, except the one being typed in
+    int cursor_line = m_tape_buffer->get_insert()->get_iter().get_line();
+    int line_count = m_tape_buffer->get_line_count();
+    m_updating_tape = true;
+    for (const auto& [line, text] : result.line_updates) {
+        if (static_cast<int>(line) == cursor_line || static_cast<int>(line) >= line_count) {
+            continue;
+        }
+        auto start = m_tape_buffer->get_iter_at_line(static_cast<int>(line));
+        auto end = start;
+        if (!end.ends_line()) {
+            end.forward_to_line_end();
+        }
+        auto iter = m_tape_buffer->erase(start, end);
+        if (text.highlight) {
+            m_tape_buffer->insert_with_tag(iter, text.text, "red-text");
+        } else {
+            m_tape_buffer->insert(iter, text.text);
         }
+    }
+    m_updating_tape = false;
 
-        // Update display with recalculated tape
-        update_displays();
-        set_modified(true);  // Mark as modified after editing
+    // Edits that reach the last calculation change the current total
+    auto snapshot = m_document->engine->snapshot();
+    if (result.reached_end) {
+        show_result(m_document->engine->formatNumber(result.running_total), result.running_total < 0);
+    } else {
+        show_result(snapshot->result, !snapshot->has_error && snapshot->running_total < 0);
     }
 }
 
+std::string MainWindow::get_tape_buffer_line(int line) {
+    auto start = m_tape_buffer->get_iter_at_line(line);
+    auto end = start;
+    if (!end.ends_line()) {
+        end.forward_to_line_end();
+    }
+    return m_tape_buffer->get_text(start, end);
+}
+
 bool MainWindow::on_key_pressed(guint keyval, guint keycode, Gdk::ModifierType state) {
+    // Latency samples start here if the key reaches the engine
+    LatencyMonitor::KeyScope latency_scope(m_latency);
+
+    // Hidden shortcut: Ctrl+Shift+F12 toggles the latency overlay
+    if ((state & Gdk::ModifierType::CONTROL_MASK) != Gdk::ModifierType{} &&
+        (state & Gdk::ModifierType::SHIFT_MASK) != Gdk::ModifierType{} &&
+        keyval == GDK_KEY_F12) {
+        toggle_latency_overlay();
+        return true;
+    }
+
     // Handle Ctrl+N to open new window - now handled by menu action
     if ((state & Gdk::ModifierType::CONTROL_MASK) != Gdk::ModifierType{} &&
         (keyval == GDK_KEY_n || keyval == GDK_KEY_N)) {
@@ -1832,11 +2602,22 @@ bool MainWindow::on_key_pressed(guint keyval, guint keycode, Gdk::ModifierType s
         return true;
     }
 
+    // Escape cancels opening files before anything else
+    if (keyval == GDK_KEY_Escape && !m_open_loads.empty()) {
+        cancel_open();
+        return true;
+    }
+
     // If in edit mode, let tape handle all keys
     if (m_tape_edit_mode) {
         return false;
     }
 
+    // Typing into the search bar must not reach the calculator
+    if (search_has_focus()) {
+        return false;
+    }
+
     // Handle number keys
     if (keyval >= GDK_KEY_0 && keyval <= GDK_KEY_9) {
         on_number_clicked(keyval - GDK_KEY_0);
@@ -1956,6 +2737,8 @@ void MainWindow::load_settings() {
         return; // No config file yet, use defaults
     }
 
+    m_loading_settings = true;
+
     std::string line;
     while (std::getline(config_file, line)) {
         // Skip empty lines and comments
@@ -1983,7 +2766,7 @@ void MainWindow::load_settings() {
             try {
                 double vat_rate = std::stod(value);
                 m_vat_rate_spin.set_value(vat_rate);
-                m_engine.setVATRate(vat_rate / 100.0);
+                m_document->engine->setVATRate(vat_rate / 100.0);
             } catch (...) {
                 // Invalid value, skip
             }
@@ -1992,11 +2775,15 @@ void MainWindow::load_settings() {
                 int places = std::stoi(value);
                 if (places >= 0 && places <= 6) {
                     m_decimal_places_spin.set_value(places);
-                    m_engine.setDecimalPlaces(places);
+                    m_document->engine->setDecimalPlaces(places);
                 }
             } catch (...) {
                 // Invalid value, skip
             }
+        } else if (key == "engine_thread") {
+            m_engine_thread_mode = (value == "1");
+        } else if (key == "tape_canvas") {
+            m_tape_canvas_mode = (value == "1");
         } else if (key == "custom_history_path") {
             // Verify the path exists before using it
             if (!value.empty() && std::filesystem::exists(value)) {
@@ -2004,9 +2791,16 @@ void MainWindow::load_settings() {
             }
         }
     }
+
+    m_loading_settings = false;
 }
 
 void MainWindow::save_settings() {
+    // Applying loaded values fires change handlers; don't write a half-loaded file
+    if (m_loading_settings) {
+        return;
+    }
+
     std::string config_path = get_config_path();
     if (config_path.empty()) {
         return;
@@ -2035,6 +2829,8 @@ void MainWindow::save_settings() {
     config_file << "# This file is auto-generated\n\n";
     config_file << "vat_rate=" << m_vat_rate_spin.get_value() << "\n";
     config_file << "decimal_places=" << m_decimal_places_spin.get_value() << "\n";
+    config_file << "engine_thread=" << (m_engine_thread_mode ? 1 : 0) << "\n";
+    config_file << "tape_canvas=" << (m_tape_canvas_mode ? 1 : 0) << "\n";
     if (!m_custom_history_path.empty()) {
         config_file << "custom_history_path=" << m_custom_history_path << "\n";
     }
@@ -2047,35 +2843,43 @@ void MainWindow::save_settings() {
 
 // File state management methods
 void MainWindow::set_modified(bool modified) {
-    m_is_modified = modified;
+    m_document->modified = modified;
+    m_modified_pending = false;
     update_window_title();
 
     // Enable/disable Save menu item based on whether a file is currently open
-    auto action_save = std::dynamic_pointer_cast<Gio::SimpleAction>(m_app->lookup_action("save"));
-    if (action_save) {
-        action_save->set_enabled(!m_current_file_path.empty());
+    set_action_enabled(m_action_save, m_save_enabled, !m_document->file_path.empty());
+}
+
+std::string MainWindow::get_document_title() const {
+    if (m_document->file_path.empty()) {
+        return APPNAME;
     }
+    // Extract filename from path
+    return std::filesystem::path(m_document->file_path).filename().string();
 }
 
 void MainWindow::update_window_title() {
     std::string title = APPNAME;
 
-    if (!m_current_file_path.empty()) {
-        // Extract filename from path
-        std::filesystem::path path(m_current_file_path);
-        title += " - " + path.filename().string();
+    if (!m_document->file_path.empty()) {
+        title += " - " + get_document_title();
     }
 
-    if (m_is_modified) {
+    if (m_document->modified) {
         title += "*";
     }
 
-    set_title(title);
+    if (m_shown_title.update(title)) {
+        set_title(title);
+    }
+    update_tab_label(*m_document);
 }
 
-bool MainWindow::check_unsaved_changes() {
-    if (!m_is_modified) {
-        return true;  // No unsaved changes, proceed
+void MainWindow::check_unsaved_changes(std::function<void()> proceed) {
+    if (!m_document->modified) {
+        proceed();  // No unsaved changes
+        return;
     }
 
     // Create alert dialog with 4 options
@@ -2086,65 +2890,99 @@ bool MainWindow::check_unsaved_changes() {
     dialog->set_default_button(3);  // Default to "Save to History"
 
     // Show dialog synchronously (blocking)
-    dialog->choose(*this, [this](const Glib::RefPtr<Gio::AsyncResult>& result) {
+    dialog->choose(*this, [this, proceed](const Glib::RefPtr<Gio::AsyncResult>& result) {
         auto dialog = std::dynamic_pointer_cast<Gtk::AlertDialog>(result->get_source_object_base());
         try {
             int button = dialog->choose_finish(result);
 
+            // Saves finish in the background; closing waits for the file
+            // to be written and does not happen if writing fails
             if (button == 3) {  // Save to History
-                save_to_history();
-                m_is_modified = false;
-                close();
+                save_to_history(proceed);
             } else if (button == 2) {  // Save As...
-                on_action_save_as();
-                // After save as dialog, check if saved and then close
-                if (!m_is_modified) {
-                    close();
-                }
+                save_as(proceed);
             } else if (button == 1) {  // Don't Save
                 // Just close without saving
-                m_is_modified = false;
-                close();
+                m_document->modified = false;
+                proceed();
             }
             // button == 0 is Cancel, do nothing
         } catch (const Gtk::DialogError& e) {
             // User cancelled or closed dialog
         }
     });
+}
 
-    return false;  // Prevent default close action, we'll handle it in the callback
+void MainWindow::save_to_file(const std::string& file_path, std::function<void()> on_saved) {
+    // Take everything the write needs now; the file itself is written on
+    // the worker pool and on_tapes_saved reports back. The file is always
+    // serialized from engine data, never from the text buffer.
+    sync_engine();
+    m_document->engine->publishSnapshot();  // Text and state describe the same moment
+    auto edited = pending_edit_engine();
+    const CalculatorEngine& engine = edited ? *edited : *m_document->engine;
+    TapeSaveRequest request;
+    request.file_path = file_path;
+    request.snapshot = engine.snapshot();
+
+    // The exact engine state goes next to the tape so reopening restores
+    // a half-finished calculation instead of re-deriving it from text
+    request.state = engine.serializeState();
+    request.owner = m_document;
+    request.revision = m_document->revision;
+
+    if (!m_tape_saver) {
+        m_tape_saver = std::make_unique<TapeSaver>([this]() {
+            m_tape_saver_dispatcher.emit();
+        });
+    }
+    uint64_t ticket = m_tape_saver->save(std::move(request));
+    if (on_saved) {
+        m_after_save[ticket] = std::move(on_saved);
+    }
 }
 
-bool MainWindow::save_to_file(const std::string& file_path) {
-    try {
-        // Get the tape content
-        std::string tape_content = m_tape_buffer->get_text();
+void MainWindow::on_tapes_saved() {
+    for (const TapeSaveResult& saved : m_tape_saver->takeFinished()) {
+        // Continuations run once the document is marked saved, and are
+        // dropped if the write failed
+        std::vector<std::function<void()>> continuations;
+        for (uint64_t ticket : saved.tickets) {
+            auto it = m_after_save.find(ticket);
+            if (it != m_after_save.end()) {
+                continuations.push_back(std::move(it->second));
+                m_after_save.erase(it);
+            }
+        }
 
-        // Write to file
-        std::ofstream outfile(file_path);
-        if (!outfile.is_open()) {
+        if (!saved.ok) {
             auto error_dialog = Gtk::AlertDialog::create("Error saving file");
-            error_dialog->set_detail("Could not write to: " + file_path);
+            error_dialog->set_detail(saved.error);
             error_dialog->show(*this);
-            return false;
+            continue;
+        }
+        add_recent_file(saved.file_path);
+
+        // The tab may have been closed while its tape was being written
+        auto it = std::find_if(m_documents.begin(), m_documents.end(),
+                               [&saved](const auto& open) { return open.get() == saved.owner; });
+        if (it != m_documents.end()) {
+            TapeDocument* document = it->get();
+            document->file_path = saved.file_path;
+
+            // Changes made after the save was requested are not in the file
+            if (document->revision == saved.revision) {
+                document->modified = false;
+            }
+            if (document == m_document) {
+                set_modified(document->modified);
+            } else {
+                update_tab_label(*document);
+            }
+        }
+        for (const auto& continuation : continuations) {
+            continuation();
         }
-
-        outfile << tape_content;
-        outfile.close();
-
-        // Update state
-        m_current_file_path = file_path;
-        set_modified(false);
-
-        // Add to recent files
-        add_recent_file(file_path);
-
-        return true;
-    } catch (const std::exception& e) {
-        auto error_dialog = Gtk::AlertDialog::create("Error saving file");
-        error_dialog->set_detail(e.what());
-        error_dialog->show(*this);
-        return false;
     }
 }
 
@@ -2152,8 +2990,9 @@ std::string MainWindow::get_history_path() {
     // If custom history path is set, use it
     if (!m_custom_history_path.empty()) {
         // Create custom history directory if it doesn't exist
-        std::filesystem::create_directories(m_custom_history_path);
-        return m_custom_history_path;
+        std::error_code error;
+        std::filesystem::create_directories(m_custom_history_path, error);
+        return error ? "" : m_custom_history_path;
     }
 
     // Otherwise use default
@@ -2168,14 +3007,18 @@ std::string MainWindow::get_history_path() {
     std::string history_dir = std::string(home) + "/.config/tape-calc/history";
 
     // Create history directory if it doesn't exist
-    std::filesystem::create_directories(history_dir);
+    std::error_code error;
+    std::filesystem::create_directories(history_dir, error);
 
-    return history_dir;
+    return error ? "" : history_dir;
 }
 
-void MainWindow::save_to_history() {
+void MainWindow::save_to_history(std::function<void()> on_saved) {
     std::string history_dir = get_history_path();
     if (history_dir.empty()) {
+        // No usable history folder; let the user pick a file instead of
+        // dropping the save (and, when closing, the close) without a word
+        save_as(on_saved);
         return;
     }
 
@@ -2189,16 +3032,19 @@ void MainWindow::save_to_history() {
 
     std::string file_path = history_dir + "/" + std::string(filename_buf);
 
-    // Save to history and add to recent files
-    if (save_to_file(file_path)) {
-        // File was saved successfully, it's already added to recent files by save_to_file
-    }
+    // Save to history; it is added to recent files once written
+    save_to_file(file_path, on_saved);
 }
 
 bool MainWindow::on_close_request() {
-    if (m_is_modified) {
-        check_unsaved_changes();
-        return true;  // Prevent close, we'll handle it in the dialog callback
+    // Ask about one tab at a time; closing again moves on to the next one
+    for (auto& document : m_documents) {
+        if (document->modified) {
+            show_document(document.get());
+            check_unsaved_changes([this]() { close(); });
+            return true;  // Prevent close, we'll handle it in the dialog callback
+        }
     }
+    write_latency_log();
     return false;  // Allow close
 }
@@ -2,33 +2,74 @@
 #define MAINWINDOW_H
 
 #include "calculator_engine.h"
+#include "consolidation_window.h"
+#include "engine_worker.h"
+#include "latency_monitor.h"
+#include "tape_document.h"
+#include "tape_edit.h"
+#include "tape_edit_worker.h"
+#include "tape_file.h"
+#include "tape_list_model.h"
+#include "tape_loader.h"
+#include "tape_pdf.h"
+#include "tape_print.h"
+#include "tape_saver.h"
+#include "tape_search.h"
+#include "tape_widget.h"
+#include "ui_state.h"
+#include "worker_pool.h"
 #include <gtkmm.h>
+#include <functional>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
-class MainWindow : public Gtk::Window
+class MainWindow : public Gtk::ApplicationWindow
 {
 public:
   MainWindow(const Glib::RefPtr<Gtk::Application>& app);
   ~MainWindow() override;
 
   // Public methods
-  void load_file(const std::string& file_path);  // Load a file programmatically
+  void load_file(const std::string& file_path);  // Opens in the background like open_files()
+  void open_files(const std::vector<std::string>& file_paths);  // Each in a tab, loaded in the background
 
 protected:
   // Application reference
   Glib::RefPtr<Gtk::Application> m_app;
 
-  // Calculator engine
-  CalculatorEngine m_engine;
+  // Open tapes, one per tab; the widgets below always show m_document
+  std::vector<std::unique_ptr<TapeDocument>> m_documents;
+  TapeDocument* m_document;
 
   // Main layout
   Gtk::Box m_outer_box;  // Outer box to contain menu bar and main content
+  Gtk::Notebook m_tabs;  // Tab strip only, shown with more than one tape
   Gtk::Box m_main_box;
   Gtk::Box m_left_panel;
   Gtk::Box m_right_panel;
   Gtk::Box m_history_title_box;
   Gtk::Label m_history_title;
 
-  // Display area
+  // Display area: a virtualized list shows the tape, the text view is only
+  // filled and shown in edit mode
+  Gtk::Overlay m_tape_overlay;
+  Gtk::SearchBar m_search_bar;  // Ctrl+F, above the tape
+  Gtk::Box m_search_box;
+  Gtk::SearchEntry m_search_entry;
+  Gtk::Button m_search_prev_button;
+  Gtk::Button m_search_next_button;
+  Gtk::Label m_search_status;
+  Gtk::Label m_latency_label;  // Debug overlay, toggled with Ctrl+Shift+F12
+  Gtk::ProgressBar m_open_progress;  // Shown over the tape while files load
+  Gtk::Stack m_tape_stack;
+  Gtk::ScrolledWindow m_tape_list_scroll;
+  Gtk::ListView m_tape_list;
+  Glib::RefPtr<TapeListModel> m_tape_model;
+  Gtk::Box m_tape_canvas_box;  // Alternative read-only view drawn by TapeWidget
+  TapeWidget m_tape_canvas;
+  Gtk::Scrollbar m_tape_canvas_scrollbar;
   Gtk::ScrolledWindow m_tape_scroll;
   Gtk::TextView m_tape_view;
   Glib::RefPtr<Gtk::TextBuffer> m_tape_buffer;
@@ -53,9 +94,6 @@ protected:
   // Calculator button grid
   Gtk::Grid m_button_grid;
 
-  // CSS Provider
-  Glib::RefPtr<Gtk::CssProvider> m_css_provider;
-
   // Constants
   const Glib::ustring APPNAME;
   const int WIDTH;
@@ -74,11 +112,67 @@ protected:
   void on_vat_rate_changed();
   void on_decimal_places_changed();
   void on_save_tape_clicked();
+  void save_as(std::function<void()> on_saved);  // on_saved runs once the file is written
   void on_edit_tape_clicked();
 
+  // Tabs
+  TapeDocument* add_document();
+  void show_document(TapeDocument* document);  // Selects its tab
+  void switch_document(TapeDocument* document);
+  void close_document(TapeDocument* document);
+  void remove_document(TapeDocument* document);
+  void on_tab_switched(Gtk::Widget* page, guint page_number);
+  void update_tab_label(TapeDocument& document);
+  void on_tapes_loaded();
+  void on_tapes_saved();
+  bool update_open_progress();  // Timer; false once nothing is loading
+  void cancel_open();
+
+  // Engine access
+  void submit_engine_command(const EngineCommand& command);
+  void sync_engine();  // Wait for the engine thread so the engine may be used directly
+  void set_engine_thread_mode(bool enabled);
+  void on_engine_changed();
+
+  // Keystroke bursts are coalesced: handlers only mark what changed and the
+  // widgets are refreshed at most once per frame from a tick callback
+  void queue_display_update();
+  void queue_modified();  // Like set_modified(true), retitling on the next frame
+  void schedule_frame_update();
+  void flush_frame_update();
+
+  // Keystroke latency instrumentation
+  void on_frame_painted();
+  void toggle_latency_overlay();
+
   // Helper methods
   void update_displays();
+  void show_result(const std::string& result, bool negative);
+  void setup_search_bar();
+  void update_search(bool jump);
+  void move_search_match(int step);
+  void show_search_matches();
+  void apply_search_classes(Gtk::Label& label, guint position);
+  bool search_has_focus();
   void update_tape();
+  void update_tape_buffer();
+  TapeEditRequest build_tape_edit_request(const EngineSnapshot& snapshot);
+  void apply_tape_edit();
+  // A copy of the engine with the uncommitted tape edits applied, so saving
+  // and printing show what the editor shows without leaving edit mode.
+  // Null when there are no such edits.
+  std::unique_ptr<CalculatorEngine> pending_edit_engine();
+  void queue_tape_edit_evaluation();
+  void submit_tape_edit_evaluation();
+  void on_tape_edit_evaluated();
+  std::string get_tape_buffer_line(int line);
+  void setup_tape_list();
+  void setup_tape_canvas();
+  void follow_tape_end(const Glib::RefPtr<Gtk::Adjustment>& vadjustment);
+  void scroll_tape_to_end();
+  void show_read_only_tape();
+  void set_tape_canvas_mode(bool enabled);
+  std::string get_entry_time_text(guint position);  // Empty for the live line
   void setup_css();
   void create_button(const Glib::ustring& label, int row, int col, int width = 1);
   void create_number_button(int number, int row, int col);
@@ -87,6 +181,7 @@ protected:
   // Menu setup
   void setup_menu();
   void update_edit_menu_sensitivity();
+  void set_action_enabled(const Glib::RefPtr<Gio::SimpleAction>& action, Tracked<bool>& state, bool enabled);
   void update_recent_files_menu();
 
   // Recent files management
@@ -104,8 +199,15 @@ protected:
   void on_action_save_as();
   void on_action_save_to_history();
   void on_action_print();
+  void on_action_find();
+  void on_action_export_pdf();
+  void on_action_export_history_pdf();
+  void on_pdf_batch_finished();
   void on_action_browse_history();
   void on_action_new_window();
+  void on_action_new_tab();
+  void on_action_close_tab();
+  void on_action_consolidation();
   void on_action_quit();
   void on_action_cut();
   void on_action_copy();
@@ -126,9 +228,13 @@ protected:
   // File state management
   void set_modified(bool modified);
   void update_window_title();
-  bool check_unsaved_changes();  // Returns false if user cancels
-  bool save_to_file(const std::string& file_path);
-  void save_to_history();
+  std::string get_document_title() const;
+  void check_unsaved_changes(std::function<void()> proceed);  // proceed runs unless the user cancels
+  // Written in the background; on_saved runs from on_tapes_saved, and only
+  // if the write succeeded
+  void save_to_file(const std::string& file_path, std::function<void()> on_saved = nullptr);
+  std::string get_state_path(const std::string& file_path);
+  void save_to_history(std::function<void()> on_saved = nullptr);
   std::string get_history_path();
 
   // Clear helper
@@ -136,17 +242,102 @@ protected:
 
   // Window close handler
   bool on_close_request() override;
+  void write_latency_log();  // Once per window
 
 private:
   bool m_updating_tape;
+
+  // What the tape buffer currently shows, for incremental updates
+  bool m_tape_render_valid;
+  uint64_t m_rendered_lineage;
+  uint64_t m_rendered_version;
+  size_t m_rendered_count;
+  int m_rendered_decimals;
+  Glib::RefPtr<Gtk::TextMark> m_tape_end_mark;
+  bool m_tape_follow_end;  // Keep the read-only tape scrolled to the last line
+
   bool m_tape_edit_mode;
+  TapeEditTracker m_tape_edit_tracker;  // Lines changed since edit mode was entered
+
+  // Tape search: matching line indices in tape order, and the list rows
+  // currently bound, which are the only ones whose highlight is updated
+  TapeSearchIndex m_search_index;
+  std::vector<size_t> m_search_matches;
+  size_t m_search_current;
+  std::unordered_map<Gtk::Label*, guint> m_bound_tape_rows;
   std::vector<std::string> m_recent_files;
   Glib::RefPtr<Gio::Menu> m_recent_files_menu;
 
-  // File state tracking
-  bool m_is_modified;
-  std::string m_current_file_path;
   std::string m_custom_history_path;
+
+  // Engine-thread mode: keystrokes are queued to a worker that owns the
+  // current document's engine (declared after m_documents so the worker is
+  // joined before the engine dies)
+  bool m_engine_thread_mode;
+  bool m_tape_canvas_mode;  // Draw the read-only tape with TapeWidget instead of the list
+
+  // Action handles, kept from setup_menu() instead of looked up per update
+  Glib::RefPtr<Gio::SimpleAction> m_action_save;
+  Glib::RefPtr<Gio::SimpleAction> m_action_save_to_history;
+  Glib::RefPtr<Gio::SimpleAction> m_action_print;
+  Glib::RefPtr<Gio::SimpleAction> m_action_export_history_pdf;
+  Glib::RefPtr<Gio::SimpleAction> m_action_cut;
+  Glib::RefPtr<Gio::SimpleAction> m_action_copy;
+  Glib::RefPtr<Gio::SimpleAction> m_action_paste;
+  Glib::RefPtr<Gio::SimpleAction> m_action_select_all;
+  Glib::RefPtr<Gio::SimpleAction> m_action_copy_total;
+
+  // What the widgets and actions currently show
+  Tracked<std::string> m_shown_result;
+  Tracked<bool> m_shown_negative;
+  Tracked<std::string> m_shown_title;
+  Tracked<bool> m_save_enabled;
+  Tracked<bool> m_save_to_history_enabled;
+  Tracked<bool> m_print_enabled;
+  Tracked<bool> m_copy_total_enabled;
+  Tracked<bool> m_edit_actions_enabled;
+
+  // Keystroke-to-frame latency, dumped to latency.log when the window
+  // closes or the application quits (windows are never deleted)
+  LatencyMonitor m_latency;
+  bool m_latency_logged;
+  sigc::connection m_after_paint_connection;
+  sigc::connection m_shutdown_connection;
+
+  // Pending per-frame UI refresh
+  bool m_display_update_pending;
+  bool m_modified_pending;
+  guint m_frame_tick_id;
+  bool m_loading_settings;
+  Glib::Dispatcher m_engine_dispatcher;
+  std::unique_ptr<EngineWorker> m_engine_worker;
+
+  // Live re-evaluation while editing the tape, at most once per frame
+  uint64_t m_tape_edit_generation;  // Bumped with every buffer edit
+  bool m_tape_edit_evaluation_pending;
+  Glib::Dispatcher m_tape_edit_dispatcher;
+  std::unique_ptr<TapeEditWorker> m_tape_edit_worker;
+
+  // History to PDF batch export, running on the worker pool
+  std::future<void> m_pdf_batch;
+  PdfBatchReport m_pdf_batch_report;
+  Glib::Dispatcher m_pdf_batch_dispatcher;
+
+  // Files opened together, parsed concurrently on the worker pool
+  Glib::Dispatcher m_tape_loader_dispatcher;
+  std::unique_ptr<TapeLoader> m_tape_loader;
+  bool m_show_next_loaded;  // Select the tab of the next tape that finishes
+  std::vector<std::shared_ptr<TapeLoadProgress>> m_open_loads;  // Files still loading
+  sigc::connection m_open_progress_timer;
+
+  // Grand total of all open tapes, created when first shown. Not added to
+  // the application, so it never keeps the application running.
+  std::unique_ptr<ConsolidationWindow> m_consolidation_window;
+
+  // Tapes being written to disk on the worker pool
+  Glib::Dispatcher m_tape_saver_dispatcher;
+  std::unique_ptr<TapeSaver> m_tape_saver;
+  std::unordered_map<uint64_t, std::function<void()>> m_after_save;  // By save ticket
 };
 
 #endif
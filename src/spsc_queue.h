@@ -0,0 +1,66 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// push() may only be called from one thread and pop() from one other thread.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_buffer(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_buffer.size() - 1)
+        , m_head(0)
+        , m_tail(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Returns false if the queue is full.
+    bool push(const T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_buffer.size()) {
+            return false;
+        }
+        m_buffer[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_buffer[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+
+private:
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<T> m_buffer;
+    const size_t m_mask;
+
+    // Head and tail live on separate cache lines so producer and consumer
+    // do not invalidate each other on every operation
+    alignas(64) std::atomic<size_t> m_head;  // Written by the consumer
+    alignas(64) std::atomic<size_t> m_tail;  // Written by the producer
+};
+
+#endif
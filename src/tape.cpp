@@ -0,0 +1,715 @@
+#include "tape.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Cold segment encoding
+//
+// codes: one byte per entry
+//   bits 0-3  op code (see OP_TABLE), or OP_ESCAPE / OP_VAT_RATE
+//   bits 4-6  decimal scale k of the value (mantissa = value * 10^k), 7 = raw double
+//   bit  7    mantissa is stored as a delta to the previous entry's mantissa
+// data: varint stream with the values referenced by the codes
+// times: zigzag varint delta of each timestamp to the previous one
+struct Tape::ColdSegment {
+    uint64_t id;
+    size_t count;
+    std::vector<uint8_t> codes;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> times;
+};
+
+namespace {
+
+const char OP_TABLE[] = {'+', '-', '*', '/', '%', '=', 'S', ' ', 'V', 'v', '\0'};
+const uint8_t OP_SEPARATOR = 7;
+const uint8_t OP_COUNT = sizeof(OP_TABLE);
+const uint8_t OP_VAT_RATE = 14;  // Not an entry: changes the running VAT rate
+const uint8_t OP_ESCAPE = 15;    // Entry stored verbatim
+
+const int SCALE_RAW = 7;
+const uint8_t DELTA_FLAG = 0x80;
+
+std::atomic<uint64_t> next_segment_id{1};
+std::atomic<uint64_t> next_lineage{1};
+
+template <typename T>
+void putPod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool getPod(const char*& in, const char* end, T& value) {
+    if (static_cast<size_t>(end - in) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return true;
+}
+
+bool getBytes(const char*& in, const char* end, uint32_t size, std::vector<uint8_t>& bytes) {
+    if (static_cast<size_t>(end - in) < size) {
+        return false;
+    }
+    bytes.assign(reinterpret_cast<const uint8_t*>(in), reinterpret_cast<const uint8_t*>(in) + size);
+    in += size;
+    return true;
+}
+
+int64_t unixMillisNow() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t getVarint(const uint8_t*& in) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        value |= static_cast<uint64_t>(*in++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<uint64_t>(*in++) << shift;
+    return value;
+}
+
+// Bounds-checked variants, for segments read from a file
+bool checkVarint(const uint8_t*& in, const uint8_t* end) {
+    for (int length = 0; length < 10 && in != end; length++) {
+        if ((*in++ & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool checkBytes(const uint8_t*& in, const uint8_t* end, size_t size) {
+    if (static_cast<size_t>(end - in) < size) {
+        return false;
+    }
+    in += size;
+    return true;
+}
+
+bool checkScaled(const uint8_t*& in, const uint8_t* end) {
+    const uint8_t* start = in;
+    if (!checkVarint(in, end)) {
+        return false;
+    }
+    uint8_t low = *start & 7;
+    return low != SCALE_RAW || checkBytes(in, end, sizeof(double));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void putRaw(std::vector<uint8_t>& out, double value) {
+    uint8_t bytes[sizeof(double)];
+    std::memcpy(bytes, &value, sizeof(double));
+    out.insert(out.end(), bytes, bytes + sizeof(double));
+}
+
+double getRaw(const uint8_t*& in) {
+    double value;
+    std::memcpy(&value, in, sizeof(double));
+    in += sizeof(double);
+    return value;
+}
+
+const double POW10[] = {1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0};
+
+// Finds the smallest decimal scale at which value round-trips exactly
+int findScale(double value, int64_t& mantissa) {
+    if (!std::isfinite(value) || std::fabs(value) >= 1e12 || (value == 0.0 && std::signbit(value))) {
+        return SCALE_RAW;
+    }
+    for (int k = 0; k < SCALE_RAW; k++) {
+        double scaled = std::nearbyint(value * POW10[k]);
+        if (scaled / POW10[k] == value) {
+            mantissa = static_cast<int64_t>(scaled);
+            return k;
+        }
+    }
+    return SCALE_RAW;
+}
+
+// Self-contained scaled value (used for VAT amounts)
+void putScaled(std::vector<uint8_t>& out, double value) {
+    int64_t mantissa = 0;
+    int k = findScale(value, mantissa);
+    if (k == SCALE_RAW) {
+        putVarint(out, SCALE_RAW);
+        putRaw(out, value);
+    } else {
+        putVarint(out, (zigzag(mantissa) << 3) | static_cast<uint64_t>(k));
+    }
+}
+
+double getScaled(const uint8_t*& in) {
+    uint64_t word = getVarint(in);
+    int k = static_cast<int>(word & 7);
+    if (k == SCALE_RAW) {
+        return getRaw(in);
+    }
+    return static_cast<double>(unzigzag(word >> 3)) / POW10[k];
+}
+
+int opCode(const TapeEntry& entry) {
+    if (entry.is_separator) {
+        bool plain = entry.operation == 'S' && entry.value == 0.0 && !entry.is_vat_operation
+                     && entry.vat_rate == 0.0 && entry.vat_amount == 0.0;
+        return plain ? OP_SEPARATOR : OP_ESCAPE;
+    }
+
+    bool vat_op = entry.operation == 'V' || entry.operation == 'v';
+    if (entry.is_vat_operation != vat_op || (!vat_op && entry.vat_amount != 0.0)) {
+        return OP_ESCAPE;
+    }
+
+    for (uint8_t code = 0; code < OP_COUNT; code++) {
+        if (code != OP_SEPARATOR && OP_TABLE[code] == entry.operation) {
+            return code;
+        }
+    }
+    return OP_ESCAPE;
+}
+
+}  // namespace
+
+std::shared_ptr<const Tape::ColdSegment> Tape::encodeSegment(std::vector<TapeEntry>::const_iterator first,
+                                                            std::vector<TapeEntry>::const_iterator last,
+                                                            const uint32_t* times) {
+    auto segment = std::make_shared<ColdSegment>();
+    segment->id = next_segment_id.fetch_add(1, std::memory_order_relaxed);
+    segment->count = static_cast<size_t>(last - first);
+    segment->codes.reserve(segment->count);
+
+    int64_t previous_time = 0;
+    for (size_t i = 0; i < segment->count; i++) {
+        putVarint(segment->times, zigzag(static_cast<int64_t>(times[i]) - previous_time));
+        previous_time = times[i];
+    }
+
+    double vat_rate = 0.0;
+    int previous_scale = -1;
+    int64_t previous_mantissa = 0;
+
+    for (auto it = first; it != last; ++it) {
+        const TapeEntry& entry = *it;
+        int code = opCode(entry);
+
+        if (code == OP_ESCAPE) {
+            segment->codes.push_back(OP_ESCAPE);
+            segment->data.push_back(static_cast<uint8_t>(entry.operation));
+            segment->data.push_back(static_cast<uint8_t>((entry.is_vat_operation ? 1 : 0) | (entry.is_separator ? 2 : 0)));
+            putRaw(segment->data, entry.value);
+            putRaw(segment->data, entry.vat_rate);
+            putRaw(segment->data, entry.vat_amount);
+            continue;
+        }
+
+        if (code == OP_SEPARATOR) {
+            segment->codes.push_back(OP_SEPARATOR);
+            continue;
+        }
+
+        if (entry.vat_rate != vat_rate) {
+            segment->codes.push_back(OP_VAT_RATE);
+            putScaled(segment->data, entry.vat_rate);
+            vat_rate = entry.vat_rate;
+        }
+
+        int64_t mantissa = 0;
+        int scale = findScale(entry.value, mantissa);
+        uint8_t byte = static_cast<uint8_t>(code | (scale << 4));
+
+        if (scale == SCALE_RAW) {
+            segment->codes.push_back(byte);
+            putRaw(segment->data, entry.value);
+        } else {
+            uint64_t absolute = zigzag(mantissa);
+            uint64_t delta = zigzag(mantissa - previous_mantissa);
+            if (scale == previous_scale && delta < absolute) {
+                segment->codes.push_back(byte | DELTA_FLAG);
+                putVarint(segment->data, delta);
+            } else {
+                segment->codes.push_back(byte);
+                putVarint(segment->data, absolute);
+            }
+            previous_scale = scale;
+            previous_mantissa = mantissa;
+        }
+
+        if (entry.is_vat_operation) {
+            putScaled(segment->data, entry.vat_amount);
+        }
+    }
+
+    segment->codes.shrink_to_fit();
+    segment->data.shrink_to_fit();
+    segment->times.shrink_to_fit();
+    return segment;
+}
+
+std::vector<uint32_t> Tape::decodeTimes(const ColdSegment& segment, size_t count) {
+    std::vector<uint32_t> times;
+    times.reserve(count);
+
+    const uint8_t* in = segment.times.data();
+    int64_t time = 0;
+    for (size_t i = 0; i < count; i++) {
+        time += unzigzag(getVarint(in));
+        times.push_back(static_cast<uint32_t>(time));
+    }
+    return times;
+}
+
+bool Tape::checkSegment(const ColdSegment& segment) {
+    // Walks the encoding like decodeSegment() but never reads past a buffer,
+    // so segments that pass can be decoded unchecked later
+    const uint8_t* times = segment.times.data();
+    const uint8_t* times_end = times + segment.times.size();
+    for (size_t i = 0; i < segment.count; i++) {
+        if (!checkVarint(times, times_end)) {
+            return false;
+        }
+    }
+
+    const uint8_t* in = segment.data.data();
+    const uint8_t* end = in + segment.data.size();
+    size_t entries = 0;
+    for (uint8_t byte : segment.codes) {
+        int code = byte & 0x0f;
+        bool ok;
+        if (code == OP_ESCAPE) {
+            ok = checkBytes(in, end, 2 + 3 * sizeof(double));
+        } else if (code == OP_SEPARATOR) {
+            ok = true;
+        } else if (code == OP_VAT_RATE) {
+            ok = checkScaled(in, end);
+            entries--;  // Not an entry
+        } else if (code >= OP_COUNT) {
+            ok = false;
+        } else {
+            bool raw = ((byte >> 4) & 7) == SCALE_RAW;
+            ok = raw ? checkBytes(in, end, sizeof(double)) : checkVarint(in, end);
+            if (ok && (OP_TABLE[code] == 'V' || OP_TABLE[code] == 'v')) {
+                ok = checkScaled(in, end);
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+        entries++;
+    }
+    return entries == segment.count && in == end;
+}
+
+Tape::Decoded Tape::decodeSegment(const ColdSegment& segment) {
+    std::vector<TapeEntry> entries;
+    entries.reserve(segment.count);
+
+    const uint8_t* in = segment.data.data();
+    double vat_rate = 0.0;
+    int64_t previous_mantissa = 0;
+
+    for (uint8_t byte : segment.codes) {
+        int code = byte & 0x0f;
+
+        if (code == OP_ESCAPE) {
+            char op = static_cast<char>(*in++);
+            uint8_t flags = *in++;
+            double value = getRaw(in);
+            double rate = getRaw(in);
+            double amount = getRaw(in);
+            TapeEntry entry(value, op, "", (flags & 1) != 0, rate, amount);
+            entry.is_separator = (flags & 2) != 0;
+            entries.push_back(std::move(entry));
+            continue;
+        }
+
+        if (code == OP_SEPARATOR) {
+            TapeEntry entry = TapeEntry::separator();
+            entry.display_text.clear();
+            entries.push_back(std::move(entry));
+            continue;
+        }
+
+        if (code == OP_VAT_RATE) {
+            vat_rate = getScaled(in);
+            continue;
+        }
+
+        int scale = (byte >> 4) & 7;
+        double value;
+        if (scale == SCALE_RAW) {
+            value = getRaw(in);
+        } else {
+            int64_t mantissa = unzigzag(getVarint(in));
+            if (byte & DELTA_FLAG) {
+                mantissa += previous_mantissa;
+            }
+            previous_mantissa = mantissa;
+            value = static_cast<double>(mantissa) / POW10[scale];
+        }
+
+        char op = OP_TABLE[code];
+        bool is_vat = op == 'V' || op == 'v';
+        double vat_amount = is_vat ? getScaled(in) : 0.0;
+        entries.emplace_back(value, op, "", is_vat, vat_rate, vat_amount);
+    }
+
+    return entries;
+}
+
+Tape::Tape()
+    : m_segments(std::make_shared<const SegmentList>())
+    , m_sealed_count(0)
+    , m_session_start(unixMillisNow())
+    , m_version(0)
+    , m_lineage(next_lineage.fetch_add(1, std::memory_order_relaxed))
+    , m_changes{}
+{
+}
+
+void Tape::recordChange(size_t index) {
+    m_version++;
+    m_changes[m_version % CHANGE_LOG_SIZE] = {m_version, index};
+}
+
+size_t Tape::firstChangedSince(uint64_t version) const {
+    if (version >= m_version) {
+        return SIZE_MAX;
+    }
+    if (m_version - version > CHANGE_LOG_SIZE) {
+        return 0;
+    }
+
+    size_t first = SIZE_MAX;
+    for (uint64_t v = version + 1; v <= m_version; v++) {
+        first = std::min(first, m_changes[v % CHANGE_LOG_SIZE].index);
+    }
+    return first;
+}
+
+std::shared_ptr<const Tape::Decoded> Tape::decodedSegment(size_t segment) const {
+    // One decoded segment per thread: rows are usually read in runs
+    struct Cache {
+        uint64_t id = 0;
+        std::shared_ptr<const Decoded> entries;
+    };
+    thread_local Cache cache;
+
+    const ColdSegment& cold = *(*m_segments)[segment];
+    if (cache.id != cold.id) {
+        cache.entries = std::make_shared<const Decoded>(decodeSegment(cold));
+        cache.id = cold.id;
+    }
+    return cache.entries;
+}
+
+TapeEntry Tape::operator[](size_t index) const {
+    if (index < m_sealed_count) {
+        return (*decodedSegment(index / CHUNK_SIZE))[index % CHUNK_SIZE];
+    }
+    return m_tail[index - m_sealed_count];
+}
+
+const TapeEntry& Tape::const_iterator::operator*() const {
+    if (m_index >= m_tape->m_sealed_count) {
+        return m_tape->m_tail[m_index - m_tape->m_sealed_count];
+    }
+    size_t segment = m_index / CHUNK_SIZE;
+    if (segment != m_segment) {
+        m_decoded = m_tape->decodedSegment(segment);
+        m_segment = segment;
+    }
+    return (*m_decoded)[m_index % CHUNK_SIZE];
+}
+
+TapeEntry& Tape::back() {
+    if (m_tail.empty()) {
+        thawLastSegment();
+    }
+    recordChange(size() - 1);
+    return m_tail.back();
+}
+
+void Tape::push_back(const TapeEntry& entry) {
+    push_back(entry, elapsedMs());
+}
+
+void Tape::push_back(const TapeEntry& entry, uint32_t timestamp) {
+    m_tail.push_back(entry);
+    m_tail_times.push_back(timestamp);
+    recordChange(size() - 1);
+
+    // Keep a full chunk in the tail so that editing or undoing the most
+    // recent entries does not immediately thaw the segment we just sealed
+    if (m_tail.size() >= 2 * CHUNK_SIZE) {
+        sealTail();
+    }
+}
+
+void Tape::append(std::vector<TapeEntry>::const_iterator first, std::vector<TapeEntry>::const_iterator last,
+                  const uint32_t* timestamps) {
+    if (first == last) {
+        return;
+    }
+    size_t count = static_cast<size_t>(last - first);
+    recordChange(size());
+    m_tail.insert(m_tail.end(), first, last);
+    m_tail_times.insert(m_tail_times.end(), timestamps, timestamps + count);
+    sealFullChunks();
+}
+
+void Tape::replace(size_t first, size_t last, std::vector<TapeEntry>::const_iterator entries_first,
+                   std::vector<TapeEntry>::const_iterator entries_last, const uint32_t* timestamps) {
+    size_t count = static_cast<size_t>(entries_last - entries_first);
+    if (first == last && count == 0) {
+        return;
+    }
+
+    // Segments before the first replaced line stay as they are. With an
+    // unchanged line count so do the segments after the last one.
+    size_t segment_count = m_segments->size();
+    size_t first_segment = std::min(first / CHUNK_SIZE, segment_count);
+    size_t end_segment = segment_count;
+    if (count == last - first) {
+        end_segment = std::min((last + CHUNK_SIZE - 1) / CHUNK_SIZE, segment_count);
+    }
+    bool through_tail = end_segment == segment_count;
+
+    size_t base = first_segment * CHUNK_SIZE;
+    std::vector<TapeEntry> lines;
+    std::vector<uint32_t> times;
+    for (size_t segment = first_segment; segment < end_segment; segment++) {
+        Decoded decoded = decodeSegment(*(*m_segments)[segment]);
+        std::vector<uint32_t> decoded_times = decodeTimes(*(*m_segments)[segment], CHUNK_SIZE);
+        lines.insert(lines.end(), decoded.begin(), decoded.end());
+        times.insert(times.end(), decoded_times.begin(), decoded_times.end());
+    }
+    if (through_tail) {
+        lines.insert(lines.end(), m_tail.begin(), m_tail.end());
+        times.insert(times.end(), m_tail_times.begin(), m_tail_times.end());
+    }
+
+    lines.erase(lines.begin() + (first - base), lines.begin() + (last - base));
+    lines.insert(lines.begin() + (first - base), entries_first, entries_last);
+    times.erase(times.begin() + (first - base), times.begin() + (last - base));
+    times.insert(times.begin() + (first - base), timestamps, timestamps + count);
+
+    // Copy-on-write: snapshots may still hold the old segment list
+    auto segments = std::make_shared<SegmentList>(*m_segments);
+    if (through_tail) {
+        segments->resize(first_segment);
+        m_segments = std::move(segments);
+        m_sealed_count = base;
+        m_tail = std::move(lines);
+        m_tail_times = std::move(times);
+        sealFullChunks();
+    } else {
+        for (size_t segment = first_segment; segment < end_segment; segment++) {
+            size_t offset = (segment - first_segment) * CHUNK_SIZE;
+            (*segments)[segment] = encodeSegment(lines.begin() + offset, lines.begin() + offset + CHUNK_SIZE,
+                                                 times.data() + offset);
+        }
+        m_segments = std::move(segments);
+    }
+    recordChange(first);
+}
+
+void Tape::sealFullChunks() {
+    if (m_tail.size() < 2 * CHUNK_SIZE) {
+        return;
+    }
+
+    // Leave between one and two chunks in the tail, as push_back() does
+    size_t sealed = (m_tail.size() - CHUNK_SIZE) / CHUNK_SIZE * CHUNK_SIZE;
+    auto segments = std::make_shared<SegmentList>(*m_segments);
+    for (size_t offset = 0; offset < sealed; offset += CHUNK_SIZE) {
+        segments->push_back(encodeSegment(m_tail.begin() + offset, m_tail.begin() + offset + CHUNK_SIZE,
+                                          m_tail_times.data() + offset));
+    }
+    m_segments = std::move(segments);
+    m_sealed_count += sealed;
+
+    m_tail.erase(m_tail.begin(), m_tail.begin() + sealed);
+    m_tail_times.erase(m_tail_times.begin(), m_tail_times.begin() + sealed);
+    m_tail.shrink_to_fit();
+    m_tail_times.shrink_to_fit();
+}
+
+void Tape::pop_back() {
+    if (m_tail.empty()) {
+        thawLastSegment();
+    }
+    m_tail.pop_back();
+    m_tail_times.pop_back();
+    recordChange(size());
+}
+
+uint32_t Tape::timestampAt(size_t index) const {
+    if (index >= m_sealed_count) {
+        return m_tail_times[index - m_sealed_count];
+    }
+    const ColdSegment& cold = *(*m_segments)[index / CHUNK_SIZE];
+    return decodeTimes(cold, index % CHUNK_SIZE + 1).back();
+}
+
+std::vector<uint32_t> Tape::timestamps() const {
+    std::vector<uint32_t> times;
+    times.reserve(size());
+    for (const auto& segment : *m_segments) {
+        std::vector<uint32_t> decoded = decodeTimes(*segment, CHUNK_SIZE);
+        times.insert(times.end(), decoded.begin(), decoded.end());
+    }
+    times.insert(times.end(), m_tail_times.begin(), m_tail_times.end());
+    return times;
+}
+
+uint32_t Tape::elapsedMs() const {
+    int64_t elapsed = unixMillisNow() - m_session_start;
+    if (elapsed < 0) {
+        return 0;
+    }
+    return elapsed > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(elapsed);
+}
+
+void Tape::clear() {
+    m_segments = std::make_shared<const SegmentList>();
+    m_sealed_count = 0;
+    m_tail.clear();
+    m_tail.shrink_to_fit();
+    m_tail_times.clear();
+    m_tail_times.shrink_to_fit();
+    m_session_start = unixMillisNow();
+    recordChange(0);
+}
+
+size_t Tape::residentBytes() const {
+    size_t bytes = m_tail.capacity() * sizeof(TapeEntry) + m_tail_times.capacity() * sizeof(uint32_t);
+    for (const auto& segment : *m_segments) {
+        bytes += sizeof(ColdSegment) + segment->codes.capacity() + segment->data.capacity()
+                 + segment->times.capacity();
+    }
+    return bytes;
+}
+
+void Tape::sealTail() {
+    auto segment = encodeSegment(m_tail.begin(), m_tail.begin() + CHUNK_SIZE, m_tail_times.data());
+    m_tail.erase(m_tail.begin(), m_tail.begin() + CHUNK_SIZE);
+    m_tail_times.erase(m_tail_times.begin(), m_tail_times.begin() + CHUNK_SIZE);
+
+    // Copy-on-write: snapshots may still hold the old segment list
+    auto segments = std::make_shared<SegmentList>(*m_segments);
+    segments->push_back(std::move(segment));
+    m_segments = std::move(segments);
+    m_sealed_count += CHUNK_SIZE;
+}
+
+void Tape::thawLastSegment() {
+    if (m_segments->empty()) {
+        return;
+    }
+
+    auto segments = std::make_shared<SegmentList>(*m_segments);
+    Decoded entries = decodeSegment(*segments->back());
+    std::vector<uint32_t> times = decodeTimes(*segments->back(), CHUNK_SIZE);
+    segments->pop_back();
+    m_segments = std::move(segments);
+    m_sealed_count -= CHUNK_SIZE;
+
+    m_tail.insert(m_tail.begin(), entries.begin(), entries.end());
+    m_tail_times.insert(m_tail_times.begin(), times.begin(), times.end());
+}
+
+void Tape::serialize(std::string& out) const {
+    auto putSegment = [&out](const ColdSegment& segment) {
+        putPod(out, static_cast<uint32_t>(segment.count));
+        putPod(out, static_cast<uint32_t>(segment.codes.size()));
+        putPod(out, static_cast<uint32_t>(segment.data.size()));
+        putPod(out, static_cast<uint32_t>(segment.times.size()));
+        out.append(segment.codes.begin(), segment.codes.end());
+        out.append(segment.data.begin(), segment.data.end());
+        out.append(segment.times.begin(), segment.times.end());
+    };
+
+    putPod(out, m_session_start);
+    putPod(out, static_cast<uint32_t>(m_segments->size()));
+    for (const auto& segment : *m_segments) {
+        putSegment(*segment);
+    }
+    putSegment(*encodeSegment(m_tail.begin(), m_tail.end(), m_tail_times.data()));
+}
+
+bool Tape::deserialize(const char*& in, const char* end) {
+    // Nothing read from the file is trusted: every count and size is
+    // checked against the bytes actually there before it is used
+    auto getSegment = [&in, end](ColdSegment& segment) {
+        uint32_t count = 0;
+        uint32_t codes_size = 0;
+        uint32_t data_size = 0;
+        uint32_t times_size = 0;
+        if (!getPod(in, end, count) || !getPod(in, end, codes_size) ||
+            !getPod(in, end, data_size) || !getPod(in, end, times_size)) {
+            return false;
+        }
+        segment.id = next_segment_id.fetch_add(1, std::memory_order_relaxed);
+        segment.count = count;
+        return count <= codes_size &&
+               getBytes(in, end, codes_size, segment.codes) &&
+               getBytes(in, end, data_size, segment.data) &&
+               getBytes(in, end, times_size, segment.times) &&
+               checkSegment(segment);
+    };
+
+    int64_t session_start = 0;
+    uint32_t segment_count = 0;
+    if (!getPod(in, end, session_start) || !getPod(in, end, segment_count)) {
+        return false;
+    }
+    const size_t SEGMENT_HEADER_SIZE = 4 * sizeof(uint32_t);
+    if (segment_count > static_cast<size_t>(end - in) / SEGMENT_HEADER_SIZE) {
+        return false;
+    }
+
+    auto segments = std::make_shared<SegmentList>();
+    segments->reserve(segment_count);
+    for (uint32_t i = 0; i < segment_count; i++) {
+        auto segment = std::make_shared<ColdSegment>();
+        if (!getSegment(*segment) || segment->count != CHUNK_SIZE) {
+            return false;
+        }
+        segments->push_back(std::move(segment));
+    }
+
+    // The tail never holds two full chunks; push_back() seals one first
+    ColdSegment tail;
+    if (!getSegment(tail) || tail.count >= 2 * CHUNK_SIZE) {
+        return false;
+    }
+
+    m_segments = std::move(segments);
+    m_sealed_count = m_segments->size() * CHUNK_SIZE;
+    m_tail = decodeSegment(tail);
+    m_tail_times = decodeTimes(tail, tail.count);
+    m_session_start = session_start;
+    recordChange(0);
+    return true;
+}
@@ -0,0 +1,170 @@
+#ifndef TAPE_H
+#define TAPE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TapeEntry {
+    double value;
+    char operation;  // '+', '-', '*', '/', '%', 'V', '=', 'S' (separator)
+    std::string display_text;
+    bool is_vat_operation;
+    bool is_separator;
+    double vat_rate;
+    double vat_amount;  // For VAT operations
+
+    TapeEntry(double v, char op, const std::string& text, bool vat = false, double rate = 0.0, double vat_amt = 0.0)
+        : value(v), operation(op), display_text(text), is_vat_operation(vat), is_separator(false), vat_rate(rate), vat_amount(vat_amt) {}
+
+    // Constructor for separator
+    static TapeEntry separator() {
+        TapeEntry entry(0.0, 'S', "---------------", false, 0.0, 0.0);
+        entry.is_separator = true;
+        return entry;
+    }
+};
+
+// Append-mostly storage for the tape history.
+//
+// Older entries are sealed into fixed-size cold segments. A cold segment is
+// immutable and compressed (one packed op/flags byte per entry plus a
+// delta/varint encoded value stream, roughly 4 bytes per line instead of a
+// full TapeEntry) and is decoded on demand for display. Segments are shared
+// between copies of the tape, so copying a Tape (e.g. for an engine
+// snapshot) only duplicates the short uncompressed tail. Mutating a sealed
+// entry through back() or pop_back() thaws the last segment first.
+//
+// Cold entries do not keep display_text; it is derived from the other fields.
+//
+// Every entry also carries a timestamp, kept in a separate column as the
+// offset in milliseconds from the session start. Cold segments store the
+// column as varint deltas, so it costs one to three bytes per line.
+class Tape {
+public:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    Tape();
+
+    size_t size() const { return m_sealed_count + m_tail.size(); }
+    bool empty() const { return size() == 0; }
+
+    // Entries are returned by value since cold ones are decoded on the fly
+    TapeEntry operator[](size_t index) const;
+    TapeEntry back() const { return (*this)[size() - 1]; }
+    TapeEntry& back();
+
+    void push_back(const TapeEntry& entry);  // Stamped with the current time
+    void push_back(const TapeEntry& entry, uint32_t timestamp);
+
+    // Same result as push_back() for each entry in turn, but seals all
+    // full chunks at once and records a single change
+    void append(std::vector<TapeEntry>::const_iterator first, std::vector<TapeEntry>::const_iterator last,
+                const uint32_t* timestamps);
+    void pop_back();
+    void clear();  // Also starts a new session
+
+    // Replaces entries [first, last) with the given ones and records a
+    // single change at first. Only the segments holding replaced lines are
+    // re-encoded; if the line count changes, every later line moves, so
+    // the segments from first on are rebuilt in one pass.
+    void replace(size_t first, size_t last, std::vector<TapeEntry>::const_iterator entries_first,
+                 std::vector<TapeEntry>::const_iterator entries_last, const uint32_t* timestamps);
+
+    // Timestamp column (milliseconds since the session start)
+    uint32_t timestampAt(size_t index) const;
+    std::vector<uint32_t> timestamps() const;  // Whole column, in entry order
+    uint32_t elapsedMs() const;
+    int64_t sessionStart() const { return m_session_start; }  // Unix time in milliseconds
+    void setSessionStart(int64_t unix_ms) { m_session_start = unix_ms; }
+
+    // Incremented on every mutation; equal versions mean equal contents
+    uint64_t version() const { return m_version; }
+
+    // Identifies the edit history versions belong to. Copies share it; a
+    // newly constructed tape starts a new one.
+    uint64_t lineage() const { return m_lineage; }
+
+    // Lowest index touched by the mutations after version, SIZE_MAX if there
+    // were none and 0 if version is too old to tell. Lets views update
+    // incrementally instead of re-rendering the whole tape.
+    size_t firstChangedSince(uint64_t version) const;
+
+    // Approximate heap memory held by this tape's entries
+    size_t residentBytes() const;
+
+    // Binary form: cold segments are written verbatim and the tail is
+    // encoded the same way, so loading is a copy plus a small fix-up
+    void serialize(std::string& out) const;
+    bool deserialize(const char*& in, const char* end);
+
+private:
+    struct ColdSegment;
+    using Decoded = std::vector<TapeEntry>;
+
+public:
+    // Decodes each cold segment once while iterating
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TapeEntry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TapeEntry*;
+        using reference = const TapeEntry&;
+
+        const_iterator(const Tape* tape, size_t index) : m_tape(tape), m_index(index), m_segment(SIZE_MAX) {}
+
+        reference operator*() const;
+        pointer operator->() const { return &**this; }
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++m_index; return tmp; }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        const Tape* m_tape;
+        size_t m_index;
+        mutable size_t m_segment;
+        mutable std::shared_ptr<const Decoded> m_decoded;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    using SegmentList = std::vector<std::shared_ptr<const ColdSegment>>;
+
+    std::shared_ptr<const SegmentList> m_segments;
+    size_t m_sealed_count;
+    std::vector<TapeEntry> m_tail;
+    std::vector<uint32_t> m_tail_times;
+    int64_t m_session_start;
+    uint64_t m_version;
+    uint64_t m_lineage;
+
+    // Ring of the most recent mutations: (version, lowest index touched)
+    static constexpr size_t CHANGE_LOG_SIZE = 32;
+    struct Change {
+        uint64_t version;
+        size_t index;
+    };
+    std::array<Change, CHANGE_LOG_SIZE> m_changes;
+    void recordChange(size_t index);
+
+    static std::shared_ptr<const ColdSegment> encodeSegment(std::vector<TapeEntry>::const_iterator first,
+                                                            std::vector<TapeEntry>::const_iterator last,
+                                                            const uint32_t* times);
+    static bool checkSegment(const ColdSegment& segment);
+    static Decoded decodeSegment(const ColdSegment& segment);
+    static std::vector<uint32_t> decodeTimes(const ColdSegment& segment, size_t count);
+    std::shared_ptr<const Decoded> decodedSegment(size_t segment) const;
+    void sealTail();
+    void sealFullChunks();
+    void thawLastSegment();
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "tape_consolidation.h"
+#include <vector>
+
+TapeConsolidation::TapeConsolidation()
+    : m_grand_total(0)
+    , m_decimal_places(2)
+    , m_next_id(1)
+    , m_next_key(1)
+{
+}
+
+TapeConsolidation& TapeConsolidation::shared() {
+    static TapeConsolidation consolidation;
+    return consolidation;
+}
+
+TapeConsolidation::Id TapeConsolidation::add(const std::string& label) {
+    Id id = m_next_id++;
+    m_sources.emplace(id, Source{label, 0.0, false});
+    notify(id, Change::ADDED);
+    return id;
+}
+
+void TapeConsolidation::remove(Id id) {
+    auto it = m_sources.find(id);
+    if (it == m_sources.end()) {
+        return;
+    }
+    m_grand_total -= counted(it->second);
+    m_sources.erase(it);
+
+    // Nothing left to drift from
+    if (m_sources.empty()) {
+        m_grand_total = 0;
+    }
+    notify(id, Change::REMOVED);
+}
+
+void TapeConsolidation::setLabel(Id id, const std::string& label) {
+    auto it = m_sources.find(id);
+    if (it == m_sources.end() || it->second.label == label) {
+        return;
+    }
+    it->second.label = label;
+    notify(id, Change::UPDATED);
+}
+
+void TapeConsolidation::setTotal(Id id, double total, bool has_error, int decimal_places) {
+    auto it = m_sources.find(id);
+    if (it == m_sources.end()) {
+        return;
+    }
+    Source& source = it->second;
+    bool places_changed = decimal_places != m_decimal_places;
+    m_decimal_places = decimal_places;
+    if (source.total == total && source.has_error == has_error && !places_changed) {
+        return;
+    }
+
+    m_grand_total -= counted(source);
+    source.total = total;
+    source.has_error = has_error;
+    m_grand_total += counted(source);
+    notify(id, Change::UPDATED);
+}
+
+const TapeConsolidation::Source* TapeConsolidation::find(Id id) const {
+    auto it = m_sources.find(id);
+    return it == m_sources.end() ? nullptr : &it->second;
+}
+
+uint64_t TapeConsolidation::subscribe(Listener listener) {
+    uint64_t key = m_next_key++;
+    m_listeners.emplace(key, std::move(listener));
+    return key;
+}
+
+void TapeConsolidation::unsubscribe(uint64_t key) {
+    m_listeners.erase(key);
+}
+
+void TapeConsolidation::notify(Id id, Change change) {
+    // A listener may subscribe or unsubscribe (itself or another one) while
+    // it is called, so walk a copy of the keys. Listeners removed meanwhile
+    // are skipped, and the one being called is kept alive by a copy.
+    std::vector<uint64_t> keys;
+    keys.reserve(m_listeners.size());
+    for (const auto& [key, listener] : m_listeners) {
+        keys.push_back(key);
+    }
+    for (uint64_t key : keys) {
+        auto it = m_listeners.find(key);
+        if (it == m_listeners.end()) {
+            continue;
+        }
+        Listener listener = it->second;
+        listener(id, change);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef TAPE_CONSOLIDATION_H
+#define TAPE_CONSOLIDATION_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Grand total over every open tape in every window.
+//
+// Each tape reports its running total whenever its display is updated; the
+// grand total moves by the difference to the value reported before, so an
+// update costs the same no matter how many tapes are open and no engine is
+// ever read from here. Listeners hear about the one tape that changed.
+//
+// Used from the GTK main thread only.
+class TapeConsolidation {
+public:
+    using Id = uint64_t;
+
+    enum class Change { ADDED, UPDATED, REMOVED };
+    using Listener = std::function<void(Id id, Change change)>;
+
+    struct Source {
+        std::string label;
+        double total;
+        bool has_error;  // Counted as 0 in the grand total
+    };
+
+    static TapeConsolidation& shared();
+
+    Id add(const std::string& label);
+    void remove(Id id);
+    void setLabel(Id id, const std::string& label);
+    void setTotal(Id id, double total, bool has_error, int decimal_places);
+
+    long double grandTotal() const { return m_grand_total; }
+    int decimalPlaces() const { return m_decimal_places; }  // Of the latest report
+    const std::unordered_map<Id, Source>& sources() const { return m_sources; }
+    const Source* find(Id id) const;
+
+    // Returns a key for unsubscribe()
+    uint64_t subscribe(Listener listener);
+    void unsubscribe(uint64_t key);
+
+private:
+    TapeConsolidation();
+
+    void notify(Id id, Change change);
+
+    static double counted(const Source& source) { return source.has_error ? 0.0 : source.total; }
+
+    std::unordered_map<Id, Source> m_sources;
+    long double m_grand_total;
+    int m_decimal_places;
+    Id m_next_id;
+    uint64_t m_next_key;
+    std::unordered_map<uint64_t, Listener> m_listeners;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "tape_document.h"
+#include <filesystem>
+
+TapeDocument::TapeDocument()
+    : engine(std::make_unique<CalculatorEngine>())
+    , modified(false)
+    , revision(0)
+    , consolidation_id(TapeConsolidation::shared().add("Untitled"))
+    , tab(Gtk::Orientation::HORIZONTAL)
+{
+    close_button.set_icon_name("window-close-symbolic");
+    close_button.set_has_frame(false);
+    close_button.set_focus_on_click(false);
+    close_button.set_tooltip_text("Close tape (Ctrl+W)");
+
+    tab.set_spacing(4);
+    tab.append(tab_label);
+    tab.append(close_button);
+}
+
+TapeDocument::~TapeDocument() {
+    TapeConsolidation::shared().remove(consolidation_id);
+}
+
+std::string TapeDocument::title() const {
+    if (file_path.empty()) {
+        return "";
+    }
+    return std::filesystem::path(file_path).filename().string();
+}
+
+bool TapeDocument::blank() const {
+    return file_path.empty() && !modified && engine->snapshot()->tape->empty();
+}
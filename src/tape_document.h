@@ -0,0 +1,40 @@
+#ifndef TAPE_DOCUMENT_H
+#define TAPE_DOCUMENT_H
+
+#include "calculator_engine.h"
+#include "tape_consolidation.h"
+#include <gtkmm.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// One open tape: its engine, its file state and its tab.
+//
+// A window keeps one document per tab but only one set of tape widgets,
+// keypad and menus; switching tabs points those at another document. The
+// notebook page of a document is an empty placeholder.
+struct TapeDocument {
+    TapeDocument();
+    ~TapeDocument();
+
+    TapeDocument(const TapeDocument&) = delete;
+    TapeDocument& operator=(const TapeDocument&) = delete;
+
+    std::string title() const;  // File name, empty for an unsaved tape
+
+    // True for a fresh tab that loading a file may reuse
+    bool blank() const;
+
+    std::unique_ptr<CalculatorEngine> engine;  // Replaced whole when a tape is loaded
+    std::string file_path;
+    bool modified;
+    uint64_t revision;  // Bumped by every change, so a finished save can tell if it is still current
+    TapeConsolidation::Id consolidation_id;  // Its line in the grand total
+
+    Gtk::Box page;
+    Gtk::Box tab;
+    Gtk::Label tab_label;
+    Gtk::Button close_button;
+};
+
+#endif
@@ -0,0 +1,378 @@
+#include "tape_edit.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+// Line form of an existing tape entry, i.e. what the rendered text parses to
+EditedLine lineFromEntry(const TapeEntry& entry, char display_operation) {
+    EditedLine line;
+    if (entry.is_separator) {
+        line.kind = EditedLine::Kind::Separator;
+    } else if (entry.is_vat_operation) {
+        line.kind = EditedLine::Kind::Vat;
+        line.operation = entry.operation == 'V' ? '+' : '-';
+        line.value = entry.vat_amount;
+        line.vat_rate = entry.vat_rate;
+    } else if (entry.operation == '=') {
+        line.kind = EditedLine::Kind::Result;
+        line.value = entry.value;
+    } else if (entry.operation == 'S') {
+        line.kind = EditedLine::Kind::Subtotal;
+        line.value = entry.value;
+    } else {
+        line.kind = EditedLine::Kind::Value;
+        line.operation = display_operation;
+        line.value = entry.value;
+    }
+    return line;
+}
+
+// True if both values look the same on the tape
+bool sameWhenShown(double a, double b, int decimal_places) {
+    char text_a[64];
+    char text_b[64];
+    std::snprintf(text_a, sizeof(text_a), "%.*f", decimal_places, a);
+    std::snprintf(text_b, sizeof(text_b), "%.*f", decimal_places, b);
+    return std::strcmp(text_a, text_b) == 0;
+}
+
+// Running state while walking the lines of a tape
+struct EditState {
+    double total = 0.0;
+    bool fresh = true;            // No value yet in the current group
+    bool at_start = true;         // Still at the top of the tape
+    bool vat_total_next = false;  // The next value line is a VAT total
+    char vat_operation = '+';
+    bool shows_result = false;    // Last line was a result or a VAT total
+    size_t last_value = SIZE_MAX; // Entry whose operation the next value sets
+};
+
+}  // namespace
+
+bool parseTapeNumber(const std::string& text, double& value) {
+    std::string number = trim(text);
+
+    // With a comma the number is European: '.' groups thousands
+    if (number.find(',') != std::string::npos) {
+        number.erase(std::remove(number.begin(), number.end(), '.'), number.end());
+        std::replace(number.begin(), number.end(), ',', '.');
+    }
+
+    if (number.empty()) {
+        return false;
+    }
+    const char* end = number.data() + number.size();
+    auto [ptr, ec] = std::from_chars(number.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+EditedLine parseEditedLine(const std::string& text) {
+    EditedLine line;
+    std::string trimmed = trim(text);
+    if (trimmed.empty()) {
+        return line;
+    }
+
+    if (trimmed.find("---") != std::string::npos) {
+        line.kind = EditedLine::Kind::Separator;
+        return line;
+    }
+
+    if (trimmed.rfind("ST", 0) == 0) {
+        if (parseTapeNumber(trimmed.substr(2), line.value)) {
+            line.kind = EditedLine::Kind::Subtotal;
+        }
+        return line;
+    }
+
+    char op = trimmed[0];
+    if (op == '=') {
+        if (parseTapeNumber(trimmed.substr(1), line.value)) {
+            line.kind = EditedLine::Kind::Result;
+        }
+        return line;
+    }
+
+    // A bare number is added
+    if (op != '+' && op != '-' && op != '*' && op != '/') {
+        if (parseTapeNumber(trimmed, line.value)) {
+            line.kind = EditedLine::Kind::Value;
+        }
+        return line;
+    }
+    line.operation = op;
+
+    // VAT lines: "+    19% | 20.88"
+    size_t percent = trimmed.find('%');
+    size_t pipe = trimmed.find('|');
+    if (percent != std::string::npos && pipe != std::string::npos && percent < pipe) {
+        double rate = 0.0;
+        if (parseTapeNumber(trimmed.substr(1, percent - 1), rate) &&
+            parseTapeNumber(trimmed.substr(pipe + 1), line.value)) {
+            line.kind = EditedLine::Kind::Vat;
+            line.vat_rate = rate / 100.0;
+        }
+        return line;
+    }
+
+    if (parseTapeNumber(trimmed.substr(1), line.value)) {
+        line.kind = EditedLine::Kind::Value;
+    }
+    return line;
+}
+
+TapeEditTracker::TapeEditTracker()
+    : m_dirty(false)
+    , m_first_dirty(0)
+    , m_last_dirty(0)
+    , m_line_shift(0)
+{
+}
+
+void TapeEditTracker::reset() {
+    m_dirty = false;
+    m_first_dirty = 0;
+    m_last_dirty = 0;
+    m_line_shift = 0;
+}
+
+void TapeEditTracker::markDirty(size_t line) {
+    if (!m_dirty) {
+        m_dirty = true;
+        m_first_dirty = line;
+        m_last_dirty = line;
+        return;
+    }
+    m_first_dirty = std::min(m_first_dirty, line);
+    m_last_dirty = std::max(m_last_dirty, line);
+}
+
+void TapeEditTracker::linesInserted(size_t line, size_t new_lines) {
+    if (m_dirty && m_last_dirty > line) {
+        m_last_dirty += new_lines;
+    }
+    markDirty(line);
+    markDirty(line + new_lines);
+    m_line_shift += static_cast<std::ptrdiff_t>(new_lines);
+}
+
+void TapeEditTracker::linesErased(size_t first_line, size_t last_line) {
+    size_t removed = last_line - first_line;
+    if (m_dirty) {
+        if (m_last_dirty > last_line) {
+            m_last_dirty -= removed;
+        } else if (m_last_dirty > first_line) {
+            m_last_dirty = first_line;
+        }
+    }
+    markDirty(first_line);
+    m_line_shift -= static_cast<std::ptrdiff_t>(removed);
+}
+
+TapeEditResult evaluateTapeEdit(const TapeEditRequest& request) {
+    const Tape& tape = *request.tape;
+    const size_t first_dirty = request.first_line;
+    const size_t last_dirty = first_dirty + request.lines.size() - 1;
+
+    TapeEditResult result;
+    EditState state;
+
+    // Find the start of the group holding the first dirty line: just after
+    // the previous result, or at the previous subtotal, whose value the
+    // group continues from
+    size_t group_start = std::min(first_dirty, tape.size());
+    while (group_start > 0) {
+        TapeEntry entry = tape[group_start - 1];
+        if (!entry.is_separator && (entry.operation == '=' || entry.operation == 'S')) {
+            state.at_start = false;
+            if (entry.operation == 'S') {
+                state.total = entry.value;
+                state.fresh = false;
+            }
+            break;
+        }
+        group_start--;
+    }
+    result.first_entry = group_start;
+
+    auto emit = [&](const TapeEntry& entry, size_t source) {
+        result.entries.push_back(entry);
+        result.sources.push_back(source);
+    };
+
+    char display_operation = displayOperationAt(tape, group_start);
+    bool in_suffix = false;
+
+    for (size_t line_index = group_start;; line_index++) {
+        // Unchanged lines before the dirty range are entries 1:1, lines after
+        // it are entries shifted by the net number of inserted lines
+        EditedLine line;
+        size_t source = SIZE_MAX;
+
+        if (line_index < first_dirty || line_index > last_dirty) {
+            std::ptrdiff_t old_index = static_cast<std::ptrdiff_t>(line_index) -
+                                       (line_index > last_dirty ? request.line_shift : 0);
+            if (old_index >= 0 && static_cast<size_t>(old_index) == tape.size() && !request.live_line.empty()) {
+                line = parseEditedLine(request.live_line);
+            } else if (old_index < 0 || static_cast<size_t>(old_index) >= tape.size()) {
+                result.reached_end = true;
+                result.old_entry_end = tape.size();
+                break;
+            } else {
+                source = static_cast<size_t>(old_index);
+                if (line_index > last_dirty && !in_suffix) {
+                    in_suffix = true;
+                    display_operation = displayOperationAt(tape, source);
+                }
+
+                TapeEntry entry = tape[source];
+                line = lineFromEntry(entry, display_operation);
+                display_operation = advanceDisplayOperation(display_operation, entry);
+            }
+        } else {
+            line = parseEditedLine(request.lines[line_index - first_dirty]);
+        }
+
+        bool recomputed = line_index >= first_dirty;
+        bool converged = false;
+        const int decimals = request.decimal_places;
+
+        switch (line.kind) {
+            case EditedLine::Kind::Blank:
+                break;
+
+            case EditedLine::Kind::Separator:
+                emit(TapeEntry::separator(), source);
+                break;
+
+            case EditedLine::Kind::Value: {
+                if (state.vat_total_next) {
+                    // The line after a VAT calculation holds its total
+                    state.vat_total_next = false;
+                    if (state.fresh) {
+                        state.total = line.value;
+                        state.fresh = false;
+                    }
+                    TapeEntry entry(state.total, state.vat_operation, "");
+                    if (recomputed && !sameWhenShown(state.total, line.value, decimals)) {
+                        result.line_updates.push_back(
+                            {line_index, formatTapeLine(entry, line.operation, decimals)});
+                    }
+                    emit(entry, state.total == line.value ? source : SIZE_MAX);
+                    state.last_value = SIZE_MAX;
+                    state.shows_result = true;
+                    break;
+                }
+
+                char op = line.operation;
+                if (state.fresh) {
+                    // A leading '-' at the top of the tape starts below zero
+                    if (state.at_start && op == '-') {
+                        emit(TapeEntry(0.0, '-', ""), SIZE_MAX);
+                        state.last_value = result.entries.size() - 1;
+                        state.total = -line.value;
+                    } else {
+                        state.total = line.value;
+                    }
+                    state.fresh = false;
+                } else {
+                    switch (op) {
+                        case '+': state.total += line.value; break;
+                        case '-': state.total -= line.value; break;
+                        case '*': state.total *= line.value; break;
+                        case '/': if (line.value != 0.0) state.total /= line.value; break;
+                    }
+                }
+                state.at_start = false;
+
+                // Entries carry the operation that follows them; the last
+                // value of a group keeps its own
+                if (state.last_value != SIZE_MAX) {
+                    result.entries[state.last_value].operation = op;
+                }
+                emit(TapeEntry(line.value, op, ""), source);
+                state.last_value = result.entries.size() - 1;
+                state.shows_result = false;
+                break;
+            }
+
+            case EditedLine::Kind::Result:
+            case EditedLine::Kind::Subtotal: {
+                bool is_result = line.kind == EditedLine::Kind::Result;
+                TapeEntry entry(state.total, is_result ? '=' : 'S', "");
+                if (recomputed && !sameWhenShown(state.total, line.value, decimals)) {
+                    result.line_updates.push_back(
+                        {line_index, formatTapeLine(entry, display_operation, decimals)});
+                }
+                emit(entry, state.total == line.value ? source : SIZE_MAX);
+
+                // Nothing after the dirty range changes once a result line
+                // (or an unchanged subtotal) has been reached
+                converged = in_suffix && source != SIZE_MAX && (is_result || state.total == line.value);
+
+                state.fresh = is_result;
+                state.shows_result = is_result;
+                state.at_start = false;
+                state.last_value = SIZE_MAX;
+                break;
+            }
+
+            case EditedLine::Kind::Vat: {
+                double base = 0.0;
+                double amount = line.value;
+                double rate = line.vat_rate;
+                TapeEntry entry(0.0, line.operation == '+' ? 'V' : 'v', "", true, rate, 0.0);
+
+                if (line.operation == '+') {
+                    base = state.fresh ? (rate != 0.0 ? amount / rate : 0.0) : state.total;
+                    amount = base * rate;
+                    entry.value = base;
+                    state.total = base + amount;
+                } else {
+                    double with_vat = state.fresh ? (rate != 0.0 ? amount * (1.0 + rate) / rate : 0.0) : state.total;
+                    base = with_vat / (1.0 + rate);
+                    amount = with_vat - base;
+                    entry.value = with_vat;
+                    state.total = base;
+                }
+                entry.vat_amount = amount;
+
+                if (recomputed && !sameWhenShown(amount, line.value, decimals)) {
+                    result.line_updates.push_back(
+                        {line_index, formatTapeLine(entry, display_operation, decimals)});
+                }
+                emit(entry, amount == line.value ? source : SIZE_MAX);
+
+                state.fresh = false;
+                state.at_start = false;
+                state.vat_total_next = true;
+                state.vat_operation = line.operation;
+                state.last_value = SIZE_MAX;
+                break;
+            }
+        }
+
+        if (converged) {
+            result.old_entry_end = source + 1;
+            break;
+        }
+    }
+
+    // An unfinished group continues with the operation of its last value
+    result.running_total = state.total;
+    result.pending_operation = state.last_value != SIZE_MAX ? result.entries[state.last_value].operation : '\0';
+    result.show_result = state.shows_result;
+    return result;
+}
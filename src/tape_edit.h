@@ -0,0 +1,98 @@
+#ifndef TAPE_EDIT_H
+#define TAPE_EDIT_H
+
+#include "tape.h"
+#include "tape_format.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One line of tape text as the user typed it in edit mode
+struct EditedLine {
+    enum class Kind : uint8_t { Blank, Value, Separator, Result, Subtotal, Vat };
+
+    Kind kind = Kind::Blank;
+    char operation = '+';  // Value: operation applied to the value; Vat: '+' or '-'
+    double value = 0.0;    // Vat: the VAT amount
+    double vat_rate = 0.0;
+};
+
+// Parses a number as shown on the tape ("1234.50") or typed in European
+// format ("1.234,50")
+bool parseTapeNumber(const std::string& text, double& value);
+
+// Lines that cannot be parsed are Blank and ignored
+EditedLine parseEditedLine(const std::string& text);
+
+// Follows TextBuffer changes during edit mode as a range of dirty lines.
+//
+// When editing starts, line i of the buffer is tape entry i. Every insertion
+// or erasure widens the dirty range and shifts the lines after it, so lines
+// outside the range are still known to be unchanged tape entries.
+class TapeEditTracker {
+public:
+    TapeEditTracker();
+
+    void reset();
+    void markDirty(size_t line);
+
+    // Called before the buffer changes. text containing new_lines newlines
+    // is inserted into line; text from first_line to last_line is erased.
+    void linesInserted(size_t line, size_t new_lines);
+    void linesErased(size_t first_line, size_t last_line);
+
+    bool dirty() const { return m_dirty; }
+    size_t firstDirtyLine() const { return m_first_dirty; }
+    size_t lastDirtyLine() const { return m_last_dirty; }
+
+    // Lines after the dirty range are old entry (line - lineShift())
+    std::ptrdiff_t lineShift() const { return m_line_shift; }
+
+private:
+    bool m_dirty;
+    size_t m_first_dirty;
+    size_t m_last_dirty;
+    std::ptrdiff_t m_line_shift;
+};
+
+// Everything needed to re-evaluate an edit; self-contained, so it can be
+// evaluated on any thread
+struct TapeEditRequest {
+    std::shared_ptr<const Tape> tape;  // The tape as it was when editing started
+    int decimal_places = 2;
+    size_t first_line = 0;             // First dirty line
+    std::vector<std::string> lines;    // Text of the dirty lines
+    std::ptrdiff_t line_shift = 0;
+    std::string live_line;             // Line after the last entry, if not dirty
+};
+
+struct TapeEditResult {
+    // Tape entries [first_entry, old_entry_end) are replaced by entries.
+    // sources holds the old index an entry was copied from, or SIZE_MAX for
+    // entries that come from edited lines.
+    size_t first_entry = 0;
+    size_t old_entry_end = 0;
+    std::vector<TapeEntry> entries;
+    std::vector<size_t> sources;
+
+    // Result, subtotal and VAT lines whose recomputed text differs
+    std::vector<std::pair<size_t, TapeLine>> line_updates;
+
+    // Calculator state after the last line, if evaluation got that far
+    bool reached_end = false;
+    double running_total = 0.0;
+    char pending_operation = '\0';
+    bool show_result = false;
+};
+
+// Re-evaluates the edited lines.
+//
+// Evaluation starts at the calculation group containing the first dirty
+// line (after the previous '=' or at the previous subtotal) and stops at the
+// first '=' after the last dirty line, since totals never carry past a
+// result. The cost depends on the size of the change, not of the tape.
+TapeEditResult evaluateTapeEdit(const TapeEditRequest& request);
+
+#endif
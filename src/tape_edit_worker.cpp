@@ -0,0 +1,70 @@
+#include "tape_edit_worker.h"
+
+TapeEditWorker::TapeEditWorker(std::function<void()> notify, WorkerPool& pool)
+    : m_pool(pool)
+    , m_notify(std::move(notify))
+    , m_request_generation(0)
+    , m_result_generation(0)
+    , m_running(false)
+{
+}
+
+TapeEditWorker::~TapeEditWorker() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_request.reset();
+    m_idle.wait(lock, [this]() { return !m_running; });
+}
+
+void TapeEditWorker::submit(TapeEditRequest request, uint64_t generation) {
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request = std::move(request);
+        m_request_generation = generation;
+        schedule = !m_running;
+        m_running = true;
+    }
+    if (schedule) {
+        m_pool.submit([this]() { run(); });
+    }
+}
+
+bool TapeEditWorker::takeResult(TapeEditResult& result, uint64_t& generation) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_result) {
+        return false;
+    }
+    result = std::move(*m_result);
+    generation = m_result_generation;
+    m_result.reset();
+    return true;
+}
+
+void TapeEditWorker::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_request) {
+        TapeEditRequest request = std::move(*m_request);
+        uint64_t generation = m_request_generation;
+        m_request.reset();
+
+        // Evaluate without the lock so newer requests can replace the queued one
+        lock.unlock();
+        TapeEditResult result = evaluateTapeEdit(request);
+        lock.lock();
+
+        // An unread result is superseded; one notification covers both
+        bool notify = !m_result;
+        m_result = std::move(result);
+        m_result_generation = generation;
+        if (notify) {
+            lock.unlock();
+            m_notify();
+            lock.lock();
+        }
+    }
+
+    // Nothing left; the next submit schedules a new task
+    m_running = false;
+    m_idle.notify_all();
+}
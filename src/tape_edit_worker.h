@@ -0,0 +1,51 @@
+#ifndef TAPE_EDIT_WORKER_H
+#define TAPE_EDIT_WORKER_H
+
+#include "tape_edit.h"
+#include "worker_pool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+// Evaluates tape edits in the background while edit mode is active.
+//
+// Requests are debounced by the caller (one per frame) and coalesced here:
+// a request that has not been started yet is replaced by a newer one, so
+// the worker only ever evaluates the latest text. Each request carries the
+// buffer generation it was built from; results for older generations are
+// stale and must not be applied to the buffer.
+//
+// Evaluation runs as a task on the shared worker pool, scheduled only while
+// there is a request; an idle worker holds no thread.
+class TapeEditWorker {
+public:
+    // notify is invoked on a pool thread and must be thread-safe
+    // (e.g. Glib::Dispatcher::emit)
+    explicit TapeEditWorker(std::function<void()> notify, WorkerPool& pool = WorkerPool::shared());
+    ~TapeEditWorker();  // Waits for a running evaluation
+
+    TapeEditWorker(const TapeEditWorker&) = delete;
+    TapeEditWorker& operator=(const TapeEditWorker&) = delete;
+
+    void submit(TapeEditRequest request, uint64_t generation);
+
+    // Returns the latest finished result, if any
+    bool takeResult(TapeEditResult& result, uint64_t& generation);
+
+private:
+    void run();  // Pool task: evaluates requests until none is queued
+
+    WorkerPool& m_pool;
+    std::function<void()> m_notify;
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::optional<TapeEditRequest> m_request;
+    uint64_t m_request_generation;
+    std::optional<TapeEditResult> m_result;
+    uint64_t m_result_generation;
+    bool m_running;  // A pool task is scheduled or evaluating
+};
+
+#endif
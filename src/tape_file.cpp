@@ -0,0 +1,441 @@
+#include "tape_file.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Read-only view of a whole file. Regular files are memory-mapped; anything
+// that cannot be mapped is read into a buffer instead.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+        : m_data(nullptr)
+        , m_size(0)
+        , m_mapped(false)
+        , m_ok(false)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            m_size = static_cast<size_t>(info.st_size);
+            if (m_size == 0) {
+                m_ok = true;
+            } else {
+                void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    ::madvise(data, m_size, MADV_SEQUENTIAL);
+                    m_data = static_cast<const char*>(data);
+                    m_mapped = true;
+                    m_ok = true;
+                }
+            }
+        }
+
+        if (!m_ok) {
+            char chunk[65536];
+            ssize_t count;
+            while ((count = ::read(fd, chunk, sizeof(chunk))) > 0) {
+                m_buffer.append(chunk, static_cast<size_t>(count));
+            }
+            m_ok = count == 0;
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (m_mapped) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool ok() const { return m_ok; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t m_size;
+    bool m_mapped;
+    bool m_ok;
+    std::string m_buffer;
+};
+
+std::string_view trim(std::string_view text, std::string_view blanks) {
+    size_t first = text.find_first_not_of(blanks);
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(blanks) - first + 1);
+}
+
+// Plain decimal number with '.' as the decimal point, independent of the
+// process locale. Like stream extraction, leading white space is skipped
+// and anything after the number is ignored.
+bool parseNumber(std::string_view text, double& value) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+        first++;
+    }
+    bool signed_plus = first != last && *first == '+';
+    if (signed_plus) {
+        first++;
+    }
+    if (first == last || !(std::isdigit(static_cast<unsigned char>(*first)) || *first == '.' ||
+                           (*first == '-' && !signed_plus))) {
+        return false;  // from_chars would also take "inf" and "nan"
+    }
+    return std::from_chars(first, last, value).ec == std::errc();
+}
+
+// Tape amounts use ',' as the decimal point and '.' between thousands.
+// scratch is reused across lines so parsing does not allocate.
+bool parseAmount(std::string_view text, bool drop_thousands, std::string& scratch, double& value) {
+    scratch.clear();
+    for (char c : text) {
+        if (c == '.' && drop_thousands) {
+            continue;
+        }
+        scratch.push_back(c == ',' ? '.' : c);
+    }
+    return parseNumber(scratch, value);
+}
+
+struct ParsedLine {
+    char operation;
+    double value;
+    bool is_vat;
+    double vat_rate;
+    double vat_amount;
+    bool is_separator;
+};
+
+// "#@timestamps <session start> <delta>..." trailer written by save_to_file()
+void parseTimestamps(std::string_view text, int64_t& session_start, std::vector<uint32_t>& timestamps) {
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    auto next = [&](int64_t& number) {
+        while (pos != end && std::isspace(static_cast<unsigned char>(*pos))) {
+            pos++;
+        }
+        if (pos != end && *pos == '+') {
+            pos++;
+            if (pos == end || *pos == '-') {
+                return false;
+            }
+        }
+        auto result = std::from_chars(pos, end, number);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        pos = result.ptr;
+        return true;
+    };
+
+    int64_t time = 0;
+    int64_t delta = 0;
+    if (next(session_start)) {
+        while (next(delta)) {
+            time += delta;
+            timestamps.push_back(static_cast<uint32_t>(std::max<int64_t>(time, 0)));
+        }
+    }
+}
+
+// Returns false for lines that hold no entry
+bool parseLine(std::string_view line, std::string& scratch, ParsedLine& parsed) {
+    // Check if it's a separator line
+    if (line.find("---") != std::string_view::npos) {
+        parsed = {' ', 0.0, false, 0.0, 0.0, true};
+        return true;
+    }
+
+    // Parse operation and value
+    if (line.length() < 3) {
+        return false;
+    }
+
+    // Check for subtotal (ST)
+    char operation = line.substr(0, 2) == "ST" ? 'S' : line[0];
+
+    // Skip if not a valid operation
+    if (operation != '+' && operation != '-' && operation != '*' &&
+        operation != '/' && operation != '=' && operation != '%' && operation != 'S') {
+        return false;
+    }
+
+    // Handle VAT lines (contains % and |)
+    size_t percent_pos = line.find('%');
+    size_t pipe_pos = line.find('|');
+    if (percent_pos != std::string_view::npos && pipe_pos != std::string_view::npos) {
+        std::string_view rate_text = trim(line.substr(1, percent_pos > 0 ? percent_pos - 1 : std::string_view::npos), " \t");
+        std::string_view amount_text = trim(line.substr(pipe_pos + 1), " \t");
+
+        double vat_rate = 0.0;
+        double vat_amount = 0.0;
+        if (!parseAmount(rate_text, false, scratch, vat_rate) ||
+            !parseAmount(amount_text, false, scratch, vat_amount)) {
+            return false;  // Skip invalid VAT line
+        }
+        parsed = {operation, vat_amount, true, vat_rate / 100.0, vat_amount, false};
+        return true;
+    }
+
+    // The value is the right side of the line
+    size_t last_space = line.find_last_of(' ');
+    std::string_view value_text = last_space != std::string_view::npos ? line.substr(last_space + 1) : line.substr(1);
+
+    double value = 0.0;
+    if (!parseAmount(trim(value_text, " \t\r\n"), true, scratch, value)) {
+        return false;
+    }
+    parsed = {operation, value, false, 0.0, 0.0, false};
+    return true;
+}
+
+// Files smaller than this are parsed by one thread
+constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+// Parsed bytes are reported (and cancellation checked) this often
+constexpr size_t PROGRESS_BYTES = 64 * 1024;
+
+// Entries of one chunk of a tape file. Regular entries store the operation
+// of the line after them; for the last entry that line may be in the next
+// chunk, which is fixed up once all chunks are parsed.
+struct ParsedChunk {
+    std::vector<TapeEntry> entries;
+    char first_operation = '\0';  // Operation of the first line, '\0' for a separator
+    bool last_takes_next = false;  // The last entry wants the next line's operation
+    std::vector<std::string_view> trailers;  // Timestamp trailers, in file order
+};
+
+void parseChunk(std::string_view text, ParsedChunk& chunk, TapeLoadProgress* progress) {
+    std::string scratch;
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    const char* reported = pos;
+    while (pos < end) {
+        if (progress && static_cast<size_t>(pos - reported) >= PROGRESS_BYTES) {
+            if (progress->cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+            progress->parsed_bytes.fetch_add(static_cast<size_t>(pos - reported), std::memory_order_relaxed);
+            reported = pos;
+        }
+
+        const char* newline = static_cast<const char*>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+        const char* line_end = newline ? newline : end;
+        std::string_view line(pos, static_cast<size_t>(line_end - pos));
+        pos = line_end + 1;
+
+        // Skip empty lines
+        if (line.empty()) continue;
+
+        if (line.substr(0, 13) == "#@timestamps ") {
+            chunk.trailers.push_back(line.substr(13));
+            continue;
+        }
+
+        ParsedLine parsed;
+        if (!parseLine(line, scratch, parsed)) {
+            continue;
+        }
+        if (chunk.entries.empty()) {
+            chunk.first_operation = parsed.is_separator ? '\0' : parsed.operation;
+        }
+
+        if (parsed.is_separator) {
+            chunk.entries.push_back(TapeEntry::separator());
+            chunk.last_takes_next = false;
+            continue;
+        }
+
+        // The previous entry stores the operation of this line (the NEXT operation)
+        if (chunk.last_takes_next) {
+            chunk.entries.back().operation = parsed.operation;
+        }
+
+        if (parsed.is_vat) {
+            char vat_op = (parsed.operation == '+') ? 'V' : 'v';
+            chunk.entries.emplace_back(parsed.value, vat_op, "", true, parsed.vat_rate, parsed.vat_amount);
+            chunk.last_takes_next = false;
+        } else {
+            // Keeps its own operation unless a line follows
+            chunk.entries.emplace_back(parsed.value, parsed.operation, "", false);
+            chunk.last_takes_next = parsed.operation != '=';
+        }
+    }
+
+    if (progress) {
+        progress->parsed_bytes.fetch_add(static_cast<size_t>(end - reported), std::memory_order_relaxed);
+    }
+}
+
+bool isCancelled(const TapeLoadProgress* progress) {
+    return progress && progress->cancelled.load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+std::string tapeStatePath(const std::string& file_path) {
+    return file_path + ".state";
+}
+
+bool loadTapeState(const std::string& file_path, CalculatorEngine& engine) {
+    std::string state_path = tapeStatePath(file_path);
+
+    // A tape edited after its state was written takes precedence
+    std::error_code ec;
+    auto state_time = std::filesystem::last_write_time(state_path, ec);
+    if (ec) {
+        return false;
+    }
+    auto tape_time = std::filesystem::last_write_time(file_path, ec);
+    if (ec || state_time < tape_time) {
+        return false;
+    }
+
+    // Deserialize straight from the mapping
+    MappedFile state_file(state_path);
+    if (!state_file.ok()) {
+        return false;
+    }
+    return engine.deserializeState(state_file.data(), state_file.size());
+}
+
+bool loadTapeText(const std::string& file_path, CalculatorEngine& engine, WorkerPool& pool,
+                  TapeLoadProgress* progress) {
+    // Lines are scanned in place in the mapped file, nothing is copied
+    MappedFile file(file_path);
+    if (!file.ok()) {
+        return false;
+    }
+    if (progress) {
+        progress->total_bytes = file.size();
+    }
+
+    // Clear current tape
+    engine.clear();
+
+    // Split at line starts into chunks that are parsed in parallel
+    std::vector<const char*> bounds{file.data()};
+    const char* end = file.data() + file.size();
+    size_t chunk_count = std::min<size_t>(pool.size() * 2, file.size() / MIN_CHUNK_BYTES);
+    for (size_t i = 1; i < chunk_count; i++) {
+        const char* split = file.data() + file.size() * i / chunk_count;
+        split = std::max(split, bounds.back());
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', static_cast<size_t>(end - split)));
+        if (!newline) {
+            break;
+        }
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(end);
+
+    std::vector<ParsedChunk> chunks(bounds.size() - 1);
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        parseChunk(std::string_view(bounds[i], static_cast<size_t>(bounds[i + 1] - bounds[i])), chunks[i], progress);
+    });
+    if (isCancelled(progress)) {
+        return false;
+    }
+
+    // Fix-up: the last entry of a chunk takes the operation of the first
+    // line of the next chunk that has any
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (!chunks[i].last_takes_next) {
+            continue;
+        }
+        for (size_t next = i + 1; next < chunks.size(); next++) {
+            if (!chunks[next].entries.empty()) {
+                if (chunks[next].first_operation != '\0') {
+                    chunks[i].entries.back().operation = chunks[next].first_operation;
+                }
+                break;
+            }
+        }
+    }
+
+    // Optional timestamp trailer written by save_to_file(), applied in file order
+    int64_t session_start = -1;
+    std::vector<uint32_t> timestamps;
+    for (const auto& chunk : chunks) {
+        for (std::string_view trailer : chunk.trailers) {
+            parseTimestamps(trailer, session_start, timestamps);
+        }
+    }
+    if (session_start >= 0) {
+        engine.setSessionStart(session_start);
+    }
+
+    // Bulk load chunk by chunk. Entries without a saved timestamp inherit
+    // the last known one.
+    uint32_t last_timestamp = timestamps.empty() ? 0 : timestamps.back();
+    std::vector<uint32_t> chunk_times;
+    size_t index = 0;
+    for (auto& chunk : chunks) {
+        chunk_times.resize(chunk.entries.size());
+        for (size_t i = 0; i < chunk.entries.size(); i++, index++) {
+            chunk_times[i] = index < timestamps.size() ? timestamps[index] : last_timestamp;
+        }
+        engine.loadTapeEntries(chunk.entries, chunk_times.data());
+        chunk.entries = {};
+        if (isCancelled(progress)) {
+            return false;
+        }
+    }
+
+    // Recalculate from loaded tape
+    engine.recalculateFromTape();
+    return true;
+}
+
+bool writeTapeFile(const EngineSnapshot& snapshot, const TapeTextSink& sink) {
+    // Every tape line ends with a newline, so the trailer starts a line
+    if (!writeTapeText(snapshot, sink)) {
+        return false;
+    }
+    if (snapshot.tape->empty()) {
+        return true;
+    }
+
+    // The timestamp column as a comment trailer (ignored by older versions)
+    std::string chunk;
+    chunk.reserve(TAPE_TEXT_CHUNK + 32);
+    chunk += "#@timestamps ";
+    chunk += std::to_string(snapshot.tape->sessionStart());
+    int64_t previous = 0;
+    char number[24];
+    for (uint32_t timestamp : snapshot.tape->timestamps()) {
+        auto result = std::to_chars(number, number + sizeof(number), static_cast<int64_t>(timestamp) - previous);
+        chunk += ' ';
+        chunk.append(number, result.ptr);
+        previous = timestamp;
+        if (chunk.size() >= TAPE_TEXT_CHUNK) {
+            if (!sink(chunk.data(), chunk.size())) {
+                return false;
+            }
+            chunk.clear();
+        }
+    }
+    chunk += '\n';
+    return sink(chunk.data(), chunk.size());
+}
@@ -0,0 +1,38 @@
+#ifndef TAPE_FILE_H
+#define TAPE_FILE_H
+
+#include "calculator_engine.h"
+#include "tape_format.h"
+#include "worker_pool.h"
+#include <atomic>
+#include <string>
+
+// Reading and writing tape files, independent of any window, so tapes can
+// also be loaded and saved by background jobs such as the PDF batch export
+
+// Binary engine state saved next to a tape file
+std::string tapeStatePath(const std::string& file_path);
+
+// Restores the exact engine state from the tape's .state file. Fails if
+// there is none or if the tape text was changed after it was written.
+bool loadTapeState(const std::string& file_path, CalculatorEngine& engine);
+
+// Shared between a background load and the window showing it
+struct TapeLoadProgress {
+    std::atomic<size_t> total_bytes{0};
+    std::atomic<size_t> parsed_bytes{0};  // Reaches total_bytes before the tape is built
+    std::atomic<bool> cancelled{false};   // Set by the window; the load then fails
+};
+
+// Parses the tape text (and its timestamp trailer) and replays it. Large
+// files are split into chunks that are parsed on the pool in parallel.
+// A cancelled load returns false and leaves the engine cleared.
+bool loadTapeText(const std::string& file_path, CalculatorEngine& engine,
+                  WorkerPool& pool = WorkerPool::shared(), TapeLoadProgress* progress = nullptr);
+
+// Streams a snapshot in the tape file format: the committed tape text
+// followed by its timestamp trailer, in chunks as writeTapeText produces
+// them. Input still being typed is kept by the state file only.
+bool writeTapeFile(const EngineSnapshot& snapshot, const TapeTextSink& sink);
+
+#endif
@@ -0,0 +1,176 @@
+#include "tape_format.h"
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <string_view>
+
+namespace {
+
+struct FixedText {
+    char data[64];
+    size_t size = 0;
+    std::string overflow;
+
+    std::string_view view() const { return overflow.empty() ? std::string_view(data, size) : overflow; }
+};
+
+bool isRegularEntry(const TapeEntry& entry) {
+    return !entry.is_separator && !entry.is_vat_operation &&
+           entry.operation != '=' && entry.operation != 'S';
+}
+
+// Fixed notation with ',' as the decimal point, as tape files store it
+// (see parseAmount in tape_file.cpp) and as the live line shows it.
+// Thousands are not grouped: "1.234" with no decimals would read back as
+// 1,234 where a '.' is taken as the decimal point, as the tape editor does.
+// Independent of the process locale.
+FixedText formatFixed(double value, int decimal_places) {
+    FixedText text;
+    auto result = std::to_chars(text.data, text.data + sizeof(text.data), value,
+                                std::chars_format::fixed, std::max(decimal_places, 0));
+    if (result.ec != std::errc()) {
+        // Only huge values with many decimals do not fit
+        std::ostringstream stream;
+        stream.imbue(std::locale::classic());
+        stream << std::fixed << std::setprecision(std::max(decimal_places, 0)) << value;
+        text.overflow = stream.str();
+        std::replace(text.overflow.begin(), text.overflow.end(), '.', ',');
+        return text;
+    }
+    text.size = static_cast<size_t>(result.ptr - text.data);
+    std::replace(text.data, text.data + text.size, '.', ',');
+    return text;
+}
+
+// Right-aligned in width columns, like std::setw
+void appendPadded(std::string& out, const FixedText& text, size_t width) {
+    std::string_view view = text.view();
+    if (view.size() < width) {
+        out.append(width - view.size(), ' ');
+    }
+    out += view;
+}
+
+}  // namespace
+
+char advanceDisplayOperation(char previous_operation, const TapeEntry& entry) {
+    return isRegularEntry(entry) ? entry.operation : previous_operation;
+}
+
+char displayOperationAt(const Tape& tape, size_t index) {
+    while (index > 0) {
+        index--;
+        TapeEntry entry = tape[index];
+        if (isRegularEntry(entry)) {
+            return entry.operation;
+        }
+    }
+    return FIRST_DISPLAY_OPERATION;
+}
+
+TapeLine formatTapeLine(const TapeEntry& entry, char previous_operation, int decimal_places) {
+    TapeLine line;
+    line.highlight = appendTapeLine(line.text, entry, previous_operation, decimal_places);
+    return line;
+}
+
+bool appendTapeLine(std::string& out, const TapeEntry& entry, char previous_operation, int decimal_places) {
+    if (entry.is_separator) {
+        out += "---------------";
+        return false;
+    }
+
+    if (entry.is_vat_operation) {
+        // Format VAT entry: "+    19% | 20.88"
+        out += entry.operation == 'V' ? '+' : '-';
+        appendPadded(out, formatFixed(entry.vat_rate * 100, 0), 13);
+        out += "% | ";
+        out += formatFixed(entry.vat_amount, decimal_places).view();
+        return false;
+    }
+
+    // Result lines use '=' and subtotals use 'ST'
+    bool highlight;
+    if (entry.operation == '=') {
+        out += "= ";
+        highlight = entry.value < 0;
+    } else if (entry.operation == 'S') {
+        out += "ST";
+        highlight = entry.value < 0;
+    } else {
+        out += previous_operation;
+        out += ' ';
+        highlight = previous_operation == '-';
+    }
+    appendPadded(out, formatFixed(entry.value, decimal_places), 13);
+    return highlight;
+}
+
+TapeLine formatGroupSummary(const TapeEntry& total, size_t line_count, int decimal_places) {
+    // Totals ignore the previous operation
+    TapeLine line = formatTapeLine(total, FIRST_DISPLAY_OPERATION, decimal_places);
+    line.text += "  \u25B8 " + std::to_string(line_count) + (line_count == 1 ? " line" : " lines");
+    return line;
+}
+
+bool formatLiveLine(const EngineSnapshot& snapshot, TapeLine& line) {
+    if (snapshot.has_error) {
+        return false;
+    }
+
+    // Pending operation line if there's a pending operation and user is typing
+    const std::string& pending_op = snapshot.pending_operation;
+    if (snapshot.new_number_started) {
+        if (pending_op.empty()) {
+            return false;
+        }
+        line = {pending_op, pending_op == "-"};
+        return true;
+    }
+
+    // Current input if user is actively typing
+    std::string current_input = snapshot.current_input;
+    if (current_input.empty() || current_input == "0") {
+        return false;
+    }
+
+    // Replace dot with comma for display (locale formatting)
+    std::replace(current_input.begin(), current_input.end(), '.', ',');
+
+    // Format: "op     value"
+    std::string op = pending_op.empty() ? " " : pending_op;
+    std::ostringstream text;
+    text << op << std::right << std::setw(14) << current_input;
+    line = {text.str(), false};
+    return true;
+}
+
+bool writeTapeText(const EngineSnapshot& snapshot, const TapeTextSink& sink) {
+    std::string chunk;
+    chunk.reserve(TAPE_TEXT_CHUNK + 256);  // One line past the limit at most
+
+    char previous_operation = FIRST_DISPLAY_OPERATION;
+    for (const TapeEntry& entry : *snapshot.tape) {
+        appendTapeLine(chunk, entry, previous_operation, snapshot.decimal_places);
+        chunk += '\n';
+        previous_operation = advanceDisplayOperation(previous_operation, entry);
+        if (chunk.size() >= TAPE_TEXT_CHUNK) {
+            if (!sink(chunk.data(), chunk.size())) {
+                return false;
+            }
+            chunk.clear();
+        }
+    }
+    return chunk.empty() || sink(chunk.data(), chunk.size());
+}
+
+std::string formatTapeText(const EngineSnapshot& snapshot) {
+    std::string text;
+    writeTapeText(snapshot, [&text](const char* data, size_t size) {
+        text.append(data, size);
+        return true;
+    });
+    return text;
+}
@@ -0,0 +1,62 @@
+#ifndef TAPE_FORMAT_H
+#define TAPE_FORMAT_H
+
+#include "calculator_engine.h"
+#include "tape.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// One rendered tape line (without the trailing newline)
+struct TapeLine {
+    std::string text;
+    bool highlight;  // Rendered in the "red-text" colour
+};
+
+// Regular lines show the operation of the previous regular entry, i.e. the
+// operation that is applied to the value on that line. The first line of a
+// tape shows '+'.
+const char FIRST_DISPLAY_OPERATION = '+';
+
+// Returns the display operation carried past entry (unchanged for results,
+// subtotals, VAT lines and separators)
+char advanceDisplayOperation(char previous_operation, const TapeEntry& entry);
+
+// Display operation in effect for the line at index (scans back to the
+// nearest regular entry)
+char displayOperationAt(const Tape& tape, size_t index);
+
+// Formats a history entry exactly as the tape view shows it
+TapeLine formatTapeLine(const TapeEntry& entry, char previous_operation, int decimal_places);
+
+// Same text appended to out, for serializing many lines without a string
+// per line. Returns whether the line is highlighted.
+bool appendTapeLine(std::string& out, const TapeEntry& entry, char previous_operation, int decimal_places);
+
+// Summary row of a collapsed calculation: its total line followed by the
+// number of lines it stands for
+TapeLine formatGroupSummary(const TapeEntry& total, size_t line_count, int decimal_places);
+
+// The line shown below the history while typing: the pending operation
+// after an operator key, or the number being entered. Returns false if
+// there is none.
+bool formatLiveLine(const EngineSnapshot& snapshot, TapeLine& line);
+
+// Receives serialized text piece by piece; returning false stops the writer
+using TapeTextSink = std::function<bool(const char* data, size_t size)>;
+
+const size_t TAPE_TEXT_CHUNK = 64 * 1024;
+
+// Streams the committed tape as plain text, one line per entry as the tape
+// view shows it, straight from the snapshot in chunks of about
+// TAPE_TEXT_CHUNK bytes. The line being typed is not part of it: reading
+// it back would turn it into an entry. The view and printouts add it with
+// formatLiveLine(). The text never exists in full, so saving a huge tape
+// needs no more memory than a small one. Returns false if the sink
+// stopped it.
+bool writeTapeText(const EngineSnapshot& snapshot, const TapeTextSink& sink);
+
+// The committed tape as plain text in one string
+std::string formatTapeText(const EngineSnapshot& snapshot);
+
+#endif
@@ -0,0 +1,128 @@
+#include "tape_groups.h"
+#include <algorithm>
+
+namespace {
+
+bool isTotalEntry(const TapeEntry& entry) {
+    return !entry.is_separator && (entry.operation == '=' || entry.operation == 'S');
+}
+
+}  // namespace
+
+TapeGroupIndex::TapeGroupIndex()
+    : m_lineage(0)
+    , m_version(0)
+    , m_line_count(0)
+    , m_scanned(0)
+    , m_tail_start(0)
+    , m_tail_row(0)
+{
+}
+
+size_t TapeGroupIndex::update(const Tape& tape) {
+    size_t first = 0;
+    if (tape.lineage() == m_lineage) {
+        first = tape.firstChangedSince(m_version);
+        if (first == SIZE_MAX) {
+            return SIZE_MAX;
+        }
+    } else {
+        // A different tape: nothing carries over, not even expanded groups
+        m_groups.clear();
+        m_scanned = 0;
+    }
+    first = std::min(first, m_line_count);
+
+    // Groups whose lines changed are found again by the scan below. They
+    // stay expanded if they still start on the same line.
+    auto dropped = std::lower_bound(m_groups.begin(), m_groups.end(), first,
+                                    [](const Group& group, size_t line) { return group.total_line < line; });
+    size_t first_group = static_cast<size_t>(dropped - m_groups.begin());
+    bool regrouped = dropped != m_groups.end();
+    std::vector<size_t> expanded;
+    for (auto it = dropped; it != m_groups.end(); ++it) {
+        if (it->expanded) {
+            expanded.push_back(it->first_line);
+        }
+    }
+    m_groups.erase(dropped, m_groups.end());
+    m_tail_start = m_groups.empty() ? 0 : m_groups.back().total_line + 1;
+
+    // Lines before the first change that were already scanned hold no total
+    size_t start = std::max(m_tail_start, std::min(first, m_scanned));
+    for (auto it = Tape::const_iterator(&tape, start); it != tape.end(); ++it, ++start) {
+        if (isTotalEntry(*it)) {
+            bool reopen = std::binary_search(expanded.begin(), expanded.end(), m_tail_start);
+            m_groups.push_back({m_tail_start, start, 0, reopen});
+            m_tail_start = start + 1;
+        }
+    }
+
+    m_line_count = tape.size();
+    m_scanned = m_line_count;
+    m_lineage = tape.lineage();
+    m_version = tape.version();
+    updateRows(first_group);
+
+    // Rows change from the first group that was dropped or found, otherwise
+    // from the first changed open line
+    if (first_group < m_groups.size()) {
+        return m_groups[first_group].row;
+    }
+    if (regrouped) {
+        return m_tail_row;
+    }
+    return m_tail_row + (first - m_tail_start);
+}
+
+void TapeGroupIndex::updateRows(size_t first_group) {
+    size_t row = first_group > 0 ? m_groups[first_group - 1].row + rowsOf(first_group - 1) : 0;
+    for (size_t group = first_group; group < m_groups.size(); group++) {
+        m_groups[group].row = row;
+        row += rowsOf(group);
+    }
+    m_tail_row = row;
+}
+
+TapeRowRef TapeGroupIndex::rowAt(size_t row) const {
+    if (row >= m_tail_row) {
+        size_t line = m_tail_start + (row - m_tail_row);
+        return {false, line, line, SIZE_MAX};
+    }
+
+    auto it = std::upper_bound(m_groups.begin(), m_groups.end(), row,
+                               [](size_t value, const Group& group) { return value < group.row; });
+    size_t group = static_cast<size_t>(it - m_groups.begin()) - 1;
+    const Group& found = m_groups[group];
+    if (!found.expanded) {
+        return {true, found.total_line, found.first_line, group};
+    }
+    size_t line = found.first_line + (row - found.row);
+    return {false, line, line, group};
+}
+
+size_t TapeGroupIndex::groupOfLine(size_t line) const {
+    if (line >= m_tail_start) {
+        return SIZE_MAX;
+    }
+    auto it = std::lower_bound(m_groups.begin(), m_groups.end(), line,
+                               [](const Group& group, size_t value) { return group.total_line < value; });
+    return static_cast<size_t>(it - m_groups.begin());
+}
+
+size_t TapeGroupIndex::rowOfLine(size_t line) const {
+    size_t group = groupOfLine(line);
+    if (group == SIZE_MAX) {
+        return m_tail_row + (line - m_tail_start);
+    }
+    const Group& found = m_groups[group];
+    return found.expanded ? found.row + (line - found.first_line) : found.row;
+}
+
+void TapeGroupIndex::setExpanded(size_t group, bool expanded) {
+    if (m_groups[group].expanded == expanded) {
+        return;
+    }
+    m_groups[group].expanded = expanded;
+    updateRows(group);
+}
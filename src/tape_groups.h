@@ -0,0 +1,67 @@
+#ifndef TAPE_GROUPS_H
+#define TAPE_GROUPS_H
+
+#include "tape.h"
+#include <cstdint>
+#include <vector>
+
+// What a row of the read-only tape shows: a single tape line, or a
+// collapsed calculation standing in for all of its lines
+struct TapeRowRef {
+    bool summary;        // Collapsed group; line is its total
+    size_t line;
+    size_t first_line;   // Lines covered by the row
+    size_t group;        // Group index, SIZE_MAX for lines after the last total
+};
+
+// Splits the tape into finished calculations (every line up to and
+// including a '=' or ST total) followed by the still open lines, and maps
+// rows to lines with finished calculations collapsed to one row unless
+// expanded.
+//
+// update() follows the tape's change log, so appending a line only looks
+// at the open lines. Rows are found by binary search over per-group row
+// offsets; lines of a collapsed group are never visited.
+class TapeGroupIndex {
+public:
+    TapeGroupIndex();
+
+    // Catches up with tape. Returns the first row whose content or position
+    // changed, or SIZE_MAX if nothing did.
+    size_t update(const Tape& tape);
+
+    size_t rowCount() const { return m_tail_row + (m_line_count - m_tail_start); }
+    TapeRowRef rowAt(size_t row) const;
+
+    // Row showing line (its group's summary row while collapsed)
+    size_t rowOfLine(size_t line) const;
+
+    size_t groupOfLine(size_t line) const;
+    size_t groupLineCount(size_t group) const { return m_groups[group].total_line - m_groups[group].first_line + 1; }
+    size_t groupRow(size_t group) const { return m_groups[group].row; }
+    bool isExpanded(size_t group) const { return m_groups[group].expanded; }
+
+    // Expands or collapses group. Rows from groupRow(group) on move.
+    void setExpanded(size_t group, bool expanded);
+
+private:
+    struct Group {
+        size_t first_line;
+        size_t total_line;
+        size_t row;  // First row of the group
+        bool expanded;
+    };
+
+    size_t rowsOf(size_t group) const { return m_groups[group].expanded ? groupLineCount(group) : 1; }
+    void updateRows(size_t first_group);
+
+    uint64_t m_lineage;
+    uint64_t m_version;
+    size_t m_line_count;
+    size_t m_scanned;     // Lines already checked for totals
+    size_t m_tail_start;  // First line after the last group
+    size_t m_tail_row;    // Row of m_tail_start
+    std::vector<Group> m_groups;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "tape_list_model.h"
+#include <algorithm>
+
+Glib::RefPtr<TapeRow> TapeRow::create(guint position) {
+    return Glib::make_refptr_for_instance<TapeRow>(new TapeRow(position));
+}
+
+TapeRow::TapeRow(guint position)
+    : m_position(position)
+{
+}
+
+Glib::RefPtr<TapeListModel> TapeListModel::create() {
+    return Glib::make_refptr_for_instance<TapeListModel>(new TapeListModel());
+}
+
+TapeListModel::TapeListModel()
+    : Glib::ObjectBase(typeid(TapeListModel))
+    , Glib::Object()
+    , Gio::ListModel()
+    , m_history_size(0)
+    , m_has_live_line(false)
+    , m_live_line{"", false}
+{
+}
+
+void TapeListModel::set_snapshot(std::shared_ptr<const EngineSnapshot> snapshot) {
+    if (snapshot == m_snapshot) {
+        return;
+    }
+
+    // Rows before the first changed entry keep their text
+    size_t changed = m_groups.update(*snapshot->tape);
+    guint first_changed = 0;
+    if (m_snapshot &&
+        snapshot->tape->lineage() == m_snapshot->tape->lineage() &&
+        snapshot->decimal_places == m_snapshot->decimal_places) {
+        first_changed = static_cast<guint>(std::min<size_t>(changed, m_history_size));
+    }
+
+    guint old_count = row_count();
+
+    TapeLine live_line{"", false};
+    bool has_live_line = formatLiveLine(*snapshot, live_line);
+    bool live_line_changed = has_live_line != m_has_live_line ||
+                             live_line.text != m_live_line.text ||
+                             live_line.highlight != m_live_line.highlight;
+
+    m_snapshot = std::move(snapshot);
+    m_history_size = static_cast<guint>(m_groups.rowCount());
+    first_changed = std::min(first_changed, m_history_size);
+    m_has_live_line = has_live_line;
+    m_live_line = std::move(live_line);
+
+    guint new_count = row_count();
+    if (first_changed == m_history_size && old_count == new_count && !live_line_changed) {
+        return;
+    }
+
+    items_changed(first_changed, old_count - first_changed, new_count - first_changed);
+}
+
+TapeLine TapeListModel::get_line(guint position) const {
+    if (!m_snapshot || position >= m_history_size) {
+        return m_live_line;
+    }
+
+    const Tape& tape = *m_snapshot->tape;
+    TapeRowRef row = m_groups.rowAt(position);
+    if (row.summary) {
+        return formatGroupSummary(tape[row.line], row.line - row.first_line + 1, m_snapshot->decimal_places);
+    }
+    return formatTapeLine(tape[row.line], displayOperationAt(tape, row.line), m_snapshot->decimal_places);
+}
+
+void TapeListModel::set_group_expanded(size_t group, bool expanded) {
+    guint row = static_cast<guint>(m_groups.groupRow(group));
+    guint lines = static_cast<guint>(m_groups.groupLineCount(group));
+
+    m_groups.setExpanded(group, expanded);
+    m_history_size = static_cast<guint>(m_groups.rowCount());
+    if (expanded) {
+        items_changed(row, 1, lines);
+    } else {
+        items_changed(row, lines, 1);
+    }
+}
+
+bool TapeListModel::toggle_group(guint position) {
+    if (!is_history_row(position)) {
+        return false;
+    }
+
+    TapeRowRef row = m_groups.rowAt(position);
+    if (row.group == SIZE_MAX) {
+        return false;
+    }
+    set_group_expanded(row.group, !m_groups.isExpanded(row.group));
+    return true;
+}
+
+guint TapeListModel::reveal_line(size_t line) {
+    size_t group = m_groups.groupOfLine(line);
+    if (group != SIZE_MAX && !m_groups.isExpanded(group)) {
+        set_group_expanded(group, true);
+    }
+    return static_cast<guint>(m_groups.rowOfLine(line));
+}
+
+GType TapeListModel::get_item_type_vfunc() {
+    return Glib::Object::get_base_type();
+}
+
+guint TapeListModel::get_n_items_vfunc() {
+    return row_count();
+}
+
+gpointer TapeListModel::get_item_vfunc(guint position) {
+    if (position >= row_count()) {
+        return nullptr;
+    }
+
+    // The caller owns the returned reference
+    auto row = TapeRow::create(position);
+    row->reference();
+    return row->gobj();
+}
@@ -0,0 +1,75 @@
+#ifndef TAPE_LIST_MODEL_H
+#define TAPE_LIST_MODEL_H
+
+#include "calculator_engine.h"
+#include "tape_format.h"
+#include "tape_groups.h"
+#include <giomm/listmodel.h>
+#include <glibmm/object.h>
+#include <memory>
+
+// List item handed to the tape view. It only records the row position; the
+// text is formatted when the row is bound.
+class TapeRow : public Glib::Object {
+public:
+    static Glib::RefPtr<TapeRow> create(guint position);
+
+    guint position() const { return m_position; }
+
+protected:
+    explicit TapeRow(guint position);
+
+private:
+    guint m_position;
+};
+
+// Gio::ListModel over an engine snapshot: one row per tape entry plus the
+// live pending/input line, except that finished calculations are collapsed
+// to a single summary row until expanded. Nothing is stored per row, so
+// memory does not grow with the tape; the view creates items and formats
+// lines only for the rows it shows, and the lines of a collapsed
+// calculation are not formatted at all.
+class TapeListModel : public Glib::Object, public Gio::ListModel {
+public:
+    static Glib::RefPtr<TapeListModel> create();
+
+    // Switches to a newer snapshot and emits items-changed for the rows
+    // from the first changed entry onwards
+    void set_snapshot(std::shared_ptr<const EngineSnapshot> snapshot);
+    std::shared_ptr<const EngineSnapshot> get_snapshot() const { return m_snapshot; }
+
+    // Formatted text of the row at position
+    TapeLine get_line(guint position) const;
+
+    // True if position is a tape entry rather than the live line
+    bool is_history_row(guint position) const { return position < m_history_size; }
+
+    // Tape lines shown by a history row
+    TapeRowRef get_row(guint position) const { return m_groups.rowAt(position); }
+
+    // Expands a collapsed calculation or collapses an expanded one. Returns
+    // false if the row is not part of a finished calculation.
+    bool toggle_group(guint position);
+
+    // Expands the calculation holding line if needed and returns its row
+    guint reveal_line(size_t line);
+
+protected:
+    TapeListModel();
+
+    GType get_item_type_vfunc() override;
+    guint get_n_items_vfunc() override;
+    gpointer get_item_vfunc(guint position) override;
+
+private:
+    guint row_count() const { return m_history_size + (m_has_live_line ? 1 : 0); }
+    void set_group_expanded(size_t group, bool expanded);
+
+    std::shared_ptr<const EngineSnapshot> m_snapshot;
+    TapeGroupIndex m_groups;
+    guint m_history_size;  // Rows before the live line
+    bool m_has_live_line;
+    TapeLine m_live_line;
+};
+
+#endif
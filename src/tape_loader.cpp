@@ -0,0 +1,82 @@
+#include "tape_loader.h"
+#include <algorithm>
+
+TapeLoader::TapeLoader(std::function<void()> notify, WorkerPool& pool)
+    : m_pool(pool)
+    , m_notify(std::move(notify))
+    , m_pending(0)
+    , m_cancelled(false)
+{
+}
+
+TapeLoader::~TapeLoader() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cancelled = true;
+    for (const auto& progress : m_loading) {
+        progress->cancelled = true;
+    }
+    m_idle.wait(lock, [this]() { return m_pending == 0; });
+}
+
+std::vector<std::shared_ptr<TapeLoadProgress>> TapeLoader::load(const std::vector<std::string>& file_paths,
+                                                                int decimal_places, double vat_rate) {
+    std::vector<std::shared_ptr<TapeLoadProgress>> progress;
+    for (size_t i = 0; i < file_paths.size(); i++) {
+        progress.push_back(std::make_shared<TapeLoadProgress>());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending += file_paths.size();
+        m_loading.insert(m_loading.end(), progress.begin(), progress.end());
+    }
+
+    for (size_t i = 0; i < file_paths.size(); i++) {
+        const std::string& file_path = file_paths[i];
+        const auto& file_progress = progress[i];
+        m_pool.submit([this, file_path, file_progress, decimal_places, vat_rate]() {
+            run(file_path, file_progress, decimal_places, vat_rate);
+        });
+    }
+    return progress;
+}
+
+std::vector<LoadedTape> TapeLoader::takeFinished() {
+    std::vector<LoadedTape> finished;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    finished.swap(m_finished);
+    return finished;
+}
+
+void TapeLoader::run(const std::string& file_path, const std::shared_ptr<TapeLoadProgress>& progress,
+                     int decimal_places, double vat_rate) {
+    bool cancelled = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancelled = m_cancelled;
+    }
+
+    LoadedTape loaded{file_path, nullptr, progress, false};
+    if (!cancelled && !progress->cancelled) {
+        auto engine = std::make_unique<CalculatorEngine>();
+        engine->setDecimalPlaces(decimal_places);
+        if (loadTapeState(file_path, *engine) || loadTapeText(file_path, *engine, m_pool, progress.get())) {
+            // Decimal places and tax rate are preferences, keep the current ones
+            engine->setDecimalPlaces(decimal_places);
+            engine->setVATRate(vat_rate);
+            engine->publishSnapshot();
+            loaded.engine = std::move(engine);
+        }
+    }
+    loaded.cancelled = progress->cancelled && !loaded.engine;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_loading.erase(std::find(m_loading.begin(), m_loading.end(), progress));
+    if (!m_cancelled) {
+        m_finished.push_back(std::move(loaded));
+        lock.unlock();
+        m_notify();
+        lock.lock();
+    }
+    m_pending--;
+    m_idle.notify_all();
+}
@@ -0,0 +1,61 @@
+#ifndef TAPE_LOADER_H
+#define TAPE_LOADER_H
+
+#include "calculator_engine.h"
+#include "tape_file.h"
+#include "worker_pool.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A tape file loaded into an engine of its own
+struct LoadedTape {
+    std::string file_path;
+    std::unique_ptr<CalculatorEngine> engine;  // Null if the file could not be read
+    std::shared_ptr<TapeLoadProgress> progress;
+    bool cancelled;
+};
+
+// Loads tape files in the background, one pool task per file.
+//
+// Files are parsed concurrently and each result is queued as soon as its
+// file is done, so the caller can show tapes one by one and a batch takes
+// about as long as its largest file. The loaded engines have published a
+// snapshot and are handed over whole; nothing else refers to them.
+class TapeLoader {
+public:
+    // notify is invoked on a pool thread after each finished file and must
+    // be thread-safe (e.g. Glib::Dispatcher::emit)
+    explicit TapeLoader(std::function<void()> notify, WorkerPool& pool = WorkerPool::shared());
+    ~TapeLoader();  // Cancels all files and waits for the ones being loaded
+
+    TapeLoader(const TapeLoader&) = delete;
+    TapeLoader& operator=(const TapeLoader&) = delete;
+
+    // Returns the progress of each file, in the same order. Setting
+    // cancelled makes that file finish early without an engine.
+    std::vector<std::shared_ptr<TapeLoadProgress>> load(const std::vector<std::string>& file_paths,
+                                                        int decimal_places, double vat_rate);
+
+    // Files finished since the last call, in the order they finished
+    std::vector<LoadedTape> takeFinished();
+
+private:
+    // Pool task
+    void run(const std::string& file_path, const std::shared_ptr<TapeLoadProgress>& progress,
+             int decimal_places, double vat_rate);
+
+    WorkerPool& m_pool;
+    std::function<void()> m_notify;
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::vector<LoadedTape> m_finished;
+    std::vector<std::shared_ptr<TapeLoadProgress>> m_loading;  // Files not finished yet
+    size_t m_pending;  // Pool tasks not yet returned
+    bool m_cancelled;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "tape_pdf.h"
+#include "tape_file.h"
+#include "tape_print.h"
+#include <cairomm/cairomm.h>
+#include <pango/pangocairo.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// A4 in points
+const double PAGE_WIDTH = 595.276;
+const double PAGE_HEIGHT = 841.89;
+
+bool isTapeFile(const std::filesystem::path& path) {
+    return path.extension() == ".txt";
+}
+
+std::string pdfPathFor(const std::filesystem::path& tape_path) {
+    std::string path = tape_path.string();
+    for (const char* suffix : {".calc.txt", ".txt"}) {
+        std::string_view ending(suffix);
+        if (path.size() > ending.size() && path.compare(path.size() - ending.size(), ending.size(), ending) == 0) {
+            return path.substr(0, path.size() - ending.size()) + ".pdf";
+        }
+    }
+    return path + ".pdf";
+}
+
+}  // namespace
+
+int exportTapePdf(std::shared_ptr<const EngineSnapshot> snapshot, const std::string& title,
+                  const std::string& pdf_path) {
+    try {
+        auto surface = Cairo::PdfSurface::create(pdf_path, PAGE_WIDTH, PAGE_HEIGHT);
+        auto cr = Cairo::Context::create(surface);
+
+        // Layouts measure in points, like a print context set to POINTS
+        TapePrintJob::LayoutFactory create_layout = [&cr]() {
+            auto layout = Pango::Layout::create(cr);
+            pango_cairo_context_set_resolution(layout->get_context()->gobj(), 72.0);
+            layout->context_changed();
+            return layout;
+        };
+
+        TapePrintJob job(std::move(snapshot), title);
+        job.paginate(create_layout, PAGE_WIDTH, PAGE_HEIGHT);
+        for (int page = 0; page < job.pageCount(); page++) {
+            job.drawPage(cr, create_layout, page);
+            cr->show_page();
+        }
+
+        surface->finish();
+        return job.pageCount();
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+PdfBatchReport exportTapeFolderPdf(const std::string& folder, int decimal_places, WorkerPool& pool) {
+    PdfBatchReport report;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::filesystem::path> tapes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+        if (entry.is_regular_file() && isTapeFile(entry.path())) {
+            tapes.push_back(entry.path());
+        }
+    }
+    report.tapes = tapes.size();
+
+    std::atomic<size_t> pages(0);
+    std::atomic<size_t> failed(0);
+    pool.parallelFor(tapes.size(), [&](size_t i) {
+        const std::string path = tapes[i].string();
+        CalculatorEngine engine;
+        if (!loadTapeState(path, engine) && !loadTapeText(path, engine)) {
+            failed.fetch_add(1);
+            return;
+        }
+        engine.setDecimalPlaces(decimal_places);
+        engine.publishSnapshot();
+
+        int written = exportTapePdf(engine.snapshot(), tapes[i].filename().string(), pdfPathFor(tapes[i]));
+        if (written == 0) {
+            failed.fetch_add(1);
+        }
+        pages.fetch_add(written);
+    });
+
+    report.pages = pages.load();
+    report.failed = failed.load();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,32 @@
+#ifndef TAPE_PDF_H
+#define TAPE_PDF_H
+
+#include "calculator_engine.h"
+#include "worker_pool.h"
+#include <memory>
+#include <string>
+
+// PDF export straight from engine data onto a Cairo PDF surface, using the
+// same pagination as printing but without a print dialog
+
+// Writes the tape to pdf_path on A4 pages. Returns the number of pages
+// written, or 0 on failure.
+int exportTapePdf(std::shared_ptr<const EngineSnapshot> snapshot, const std::string& title,
+                  const std::string& pdf_path);
+
+struct PdfBatchReport {
+    size_t tapes = 0;
+    size_t failed = 0;
+    size_t pages = 0;
+    double seconds = 0.0;
+
+    double pagesPerSecond() const { return seconds > 0.0 ? pages / seconds : 0.0; }
+};
+
+// Converts every tape file in folder into a PDF next to it. Files are
+// spread over the worker pool; each file is loaded into its own engine and
+// rendered onto its own surface, so nothing is shared between them.
+PdfBatchReport exportTapeFolderPdf(const std::string& folder, int decimal_places,
+                                   WorkerPool& pool = WorkerPool::shared());
+
+#endif
@@ -0,0 +1,190 @@
+#include "tape_print.h"
+#include "tape_format.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char* const PRINT_FONT = "monospace 10";
+
+// Running total while walking the tape, following the same rules the
+// engine applies when it replays a tape
+struct RunningTotal {
+    double total = 0.0;
+    char pending = '\0';  // Operation applied to the next value, '\0' if none
+
+    void apply(const TapeEntry& entry) {
+        if (entry.is_separator) {
+            return;
+        }
+        if (entry.operation == '=' || entry.operation == 'S') {
+            total = entry.value;
+            pending = '\0';
+        } else if (entry.is_vat_operation) {
+            total = entry.operation == 'V' ? entry.value + entry.vat_amount : entry.value - entry.vat_amount;
+            pending = '\0';
+        } else {
+            switch (pending) {
+                case '\0': total = entry.value; break;
+                case '+': total += entry.value; break;
+                case '-': total -= entry.value; break;
+                case '*': total *= entry.value; break;
+                case '/': if (entry.value != 0.0) total /= entry.value; break;
+            }
+            pending = entry.operation;
+        }
+    }
+
+    // True while a calculation is open, i.e. not finished with '='
+    bool open() const { return pending != '\0'; }
+};
+
+}  // namespace
+
+TapePrintJob::TapePrintJob(std::shared_ptr<const EngineSnapshot> snapshot, std::string title)
+    : m_snapshot(std::move(snapshot))
+    , m_title(std::move(title))
+    , m_line_count(0)
+    , m_width(0.0)
+    , m_line_height(0.0)
+{
+}
+
+Glib::RefPtr<Pango::Layout> TapePrintJob::createLayout(const LayoutFactory& create_layout) const {
+    auto layout = create_layout();
+    layout->set_font_description(Pango::FontDescription(PRINT_FONT));
+    return layout;
+}
+
+std::string TapePrintJob::formatTotal(double value) const {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(m_snapshot->decimal_places) << value;
+    return text.str();
+}
+
+void TapePrintJob::paginate(const LayoutFactory& create_layout, double width, double height) {
+    auto measure = createLayout(create_layout);
+    measure->set_text("0");
+    int text_width = 0;
+    int text_height = 0;
+    measure->get_size(text_width, text_height);
+    m_line_height = static_cast<double>(text_height) / Pango::SCALE;
+    m_width = width;
+
+    double body_height = height - 2 * MARGIN - (HEADER_LINES + FOOTER_LINES) * m_line_height;
+    size_t lines_per_page = static_cast<size_t>(std::max(1.0, body_height / m_line_height));
+
+    const Tape& tape = *m_snapshot->tape;
+    TapeLine live_line;
+    m_line_count = tape.size() + (formatLiveLine(*m_snapshot, live_line) ? 1 : 0);
+
+    // One pass over the tape: break every lines_per_page lines and note the
+    // totals at each break
+    m_pages.clear();
+    RunningTotal running;
+    char operation = FIRST_DISPLAY_OPERATION;
+    size_t line = 0;
+    do {
+        TapePage page;
+        page.first_line = line;
+        page.first_operation = operation;
+        page.carried = running.open();
+        page.carried_total = running.total;
+
+        size_t end = std::min(m_line_count, line + lines_per_page);
+        for (; line < end && line < tape.size(); line++) {
+            TapeEntry entry = tape[line];
+            running.apply(entry);
+            operation = advanceDisplayOperation(operation, entry);
+        }
+        line = end;
+
+        page.end_line = end;
+        page.page_total = running.total;
+        m_pages.push_back(page);
+    } while (line < m_line_count);
+
+    m_page_bodies.assign(m_pages.size(), {});
+}
+
+Glib::RefPtr<Pango::Layout> TapePrintJob::pageBody(const LayoutFactory& create_layout, int index) {
+    if (m_page_bodies[index]) {
+        return m_page_bodies[index];
+    }
+
+    const TapePage& page = m_pages[index];
+    const Tape& tape = *m_snapshot->tape;
+    std::string text;
+    Pango::AttrList attributes;
+    char operation = page.first_operation;
+
+    for (size_t line = page.first_line; line < page.end_line; line++) {
+        TapeLine tape_line;
+        if (line < tape.size()) {
+            TapeEntry entry = tape[line];
+            tape_line = formatTapeLine(entry, operation, m_snapshot->decimal_places);
+            operation = advanceDisplayOperation(operation, entry);
+        } else {
+            formatLiveLine(*m_snapshot, tape_line);
+        }
+
+        if (tape_line.highlight) {
+            auto colour = Pango::Attribute::create_attr_foreground(0xD8D8, 0x6A6A, 0x3535);
+            colour.set_start_index(text.size());
+            colour.set_end_index(text.size() + tape_line.text.size());
+            attributes.insert(colour);
+        }
+        text += tape_line.text;
+        text += '\n';
+    }
+
+    auto layout = createLayout(create_layout);
+    layout->set_text(text);
+    layout->set_attributes(attributes);
+    m_page_bodies[index] = layout;
+    return layout;
+}
+
+void TapePrintJob::drawPage(const Cairo::RefPtr<Cairo::Context>& cr, const LayoutFactory& create_layout, int index) {
+    if (index < 0 || index >= pageCount()) {
+        return;
+    }
+    const TapePage& page = m_pages[index];
+    auto text = createLayout(create_layout);
+    double y = MARGIN;
+
+    cr->set_source_rgb(0.0, 0.0, 0.0);
+
+    // Header: title on the left, page number on the right
+    text->set_width(static_cast<int>((m_width - 2 * MARGIN) * Pango::SCALE));
+    text->set_text(m_title);
+    cr->move_to(MARGIN, y);
+    text->show_in_cairo_context(cr);
+
+    text->set_alignment(Pango::Alignment::RIGHT);
+    text->set_text("Page " + std::to_string(index + 1) + " of " + std::to_string(pageCount()));
+    cr->move_to(MARGIN, y);
+    text->show_in_cairo_context(cr);
+    text->set_alignment(Pango::Alignment::LEFT);
+    y += 2 * m_line_height;
+
+    // A calculation running over the page break starts from its subtotal
+    if (page.carried) {
+        text->set_text("Carried forward: " + formatTotal(page.carried_total));
+        cr->move_to(MARGIN, y);
+        text->show_in_cairo_context(cr);
+    }
+    y += m_line_height;
+
+    auto body = pageBody(create_layout, index);
+    cr->move_to(MARGIN, y);
+    body->show_in_cairo_context(cr);
+    y += (page.end_line - page.first_line + 1) * m_line_height;
+
+    if (page.end_line > page.first_line) {
+        text->set_text("Page total: " + formatTotal(page.page_total));
+        cr->move_to(MARGIN, y);
+        text->show_in_cairo_context(cr);
+    }
+}
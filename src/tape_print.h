@@ -0,0 +1,61 @@
+#ifndef TAPE_PRINT_H
+#define TAPE_PRINT_H
+
+#include "calculator_engine.h"
+#include <gtkmm.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One printed page: a range of tape lines plus the running totals around it
+struct TapePage {
+    size_t first_line;
+    size_t end_line;
+    char first_operation;  // Display operation in effect for first_line
+    bool carried;          // A calculation continues from the previous page
+    double carried_total;  // Running total brought forward
+    double page_total;     // Running total at the bottom of the page
+};
+
+// Splits a tape snapshot into pages and draws them onto a Cairo context.
+//
+// paginate() computes every page break and the running totals at the
+// breaks in one pass over the engine data. drawPage() formats only the
+// lines of the requested page, so drawing a page costs the same on a
+// 20-line tape and on a 50k-line one. Body layouts are cached per page
+// because print previews redraw pages.
+class TapePrintJob {
+public:
+    using LayoutFactory = std::function<Glib::RefPtr<Pango::Layout>()>;
+
+    TapePrintJob(std::shared_ptr<const EngineSnapshot> snapshot, std::string title);
+
+    // width and height are the printable area in the units of the layouts
+    // create_layout returns (points for printing and PDF)
+    void paginate(const LayoutFactory& create_layout, double width, double height);
+
+    int pageCount() const { return static_cast<int>(m_pages.size()); }
+    const TapePage& page(int index) const { return m_pages[index]; }
+
+    void drawPage(const Cairo::RefPtr<Cairo::Context>& cr, const LayoutFactory& create_layout, int index);
+
+private:
+    static constexpr double MARGIN = 36.0;  // Half an inch
+    static constexpr int HEADER_LINES = 3;  // Title, blank line, carried total
+    static constexpr int FOOTER_LINES = 2;  // Blank line, page total
+
+    Glib::RefPtr<Pango::Layout> createLayout(const LayoutFactory& create_layout) const;
+    Glib::RefPtr<Pango::Layout> pageBody(const LayoutFactory& create_layout, int index);
+    std::string formatTotal(double value) const;
+
+    std::shared_ptr<const EngineSnapshot> m_snapshot;
+    std::string m_title;
+    size_t m_line_count;  // History lines plus the line being typed
+    double m_width;
+    double m_line_height;
+    std::vector<TapePage> m_pages;
+    std::vector<Glib::RefPtr<Pango::Layout>> m_page_bodies;
+};
+
+#endif
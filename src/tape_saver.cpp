@@ -0,0 +1,100 @@
+#include "tape_saver.h"
+#include "atomic_file.h"
+#include "tape_file.h"
+#include <algorithm>
+
+namespace {
+
+bool writeTape(const TapeSaveRequest& request, mode_t file_mode, std::string& error) {
+    // Streamed from the snapshot; the tape text is never built in full
+    AtomicFile tape_file(request.file_path, file_mode);
+    writeTapeFile(*request.snapshot, [&tape_file](const char* data, size_t size) {
+        return tape_file.write(data, size);
+    });
+
+    // The state is written after the tape so it is never older than it;
+    // if only the tape gets replaced, the old state is ignored on load
+    AtomicFile state_file(tapeStatePath(request.file_path), file_mode);
+    state_file.write(request.state.data(), request.state.size());
+
+    if (!tape_file.commit()) {
+        error = tape_file.error();
+        return false;
+    }
+    state_file.commit();  // Optional; the tape text alone restores the tape
+    return true;
+}
+
+}  // namespace
+
+TapeSaver::TapeSaver(std::function<void()> notify, WorkerPool& pool)
+    : m_pool(pool)
+    , m_notify(std::move(notify))
+    , m_file_mode(defaultFileMode())
+    , m_next_ticket(1)
+    , m_running(false)
+{
+}
+
+TapeSaver::~TapeSaver() {
+    // Unlike loads and edits, saves are never dropped
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return !m_running; });
+}
+
+uint64_t TapeSaver::save(TapeSaveRequest request) {
+    bool schedule = false;
+    uint64_t ticket = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ticket = m_next_ticket++;
+        auto queued = std::find_if(m_queue.begin(), m_queue.end(), [&request](const Queued& other) {
+            return other.request.file_path == request.file_path && other.request.owner == request.owner;
+        });
+        if (queued != m_queue.end()) {
+            queued->request = std::move(request);
+            queued->tickets.push_back(ticket);
+        } else {
+            m_queue.push_back({std::move(request), {ticket}});
+        }
+        schedule = !m_running;
+        m_running = true;
+    }
+    if (schedule) {
+        m_pool.submit([this]() { run(); });
+    }
+    return ticket;
+}
+
+std::vector<TapeSaveResult> TapeSaver::takeFinished() {
+    std::vector<TapeSaveResult> finished;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    finished.swap(m_finished);
+    return finished;
+}
+
+void TapeSaver::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_queue.empty()) {
+        Queued queued = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        // Write without the lock so newer saves can be queued or coalesced
+        lock.unlock();
+        const TapeSaveRequest& request = queued.request;
+        TapeSaveResult result{request.file_path, request.owner, request.revision,
+                              std::move(queued.tickets), false, ""};
+        result.ok = writeTape(request, m_file_mode, result.error);
+        lock.lock();
+
+        m_finished.push_back(std::move(result));
+        lock.unlock();
+        m_notify();
+        lock.lock();
+    }
+
+    // Nothing left; the next save schedules a new task
+    m_running = false;
+    m_idle.notify_all();
+}
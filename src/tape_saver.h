@@ -0,0 +1,81 @@
+#ifndef TAPE_SAVER_H
+#define TAPE_SAVER_H
+
+#include "calculator_engine.h"
+#include "worker_pool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Everything needed to write a tape and its state file, taken on the UI
+// thread so the write itself touches no live engine or widget
+struct TapeSaveRequest {
+    std::string file_path;
+    std::shared_ptr<const EngineSnapshot> snapshot;
+    std::string state;                // CalculatorEngine::serializeState()
+
+    // Returned unchanged with the result so the caller can tell which
+    // document, and which version of it, was saved
+    const void* owner;
+    uint64_t revision;
+};
+
+struct TapeSaveResult {
+    std::string file_path;
+    const void* owner;
+    uint64_t revision;
+    std::vector<uint64_t> tickets;  // Of every save() this write completes
+    bool ok;
+    std::string error;  // Set if not ok
+};
+
+// Writes tapes in the background.
+//
+// Each file is written to a temporary file, flushed to disk and renamed
+// over the old one, so a crash or a full disk never leaves a truncated
+// tape. Saves run one at a time in the order they were requested; a save
+// that has not started yet is replaced by a newer one from the same owner
+// for the same file.
+class TapeSaver {
+public:
+    // notify is invoked on a pool thread after each finished save and must
+    // be thread-safe (e.g. Glib::Dispatcher::emit)
+    explicit TapeSaver(std::function<void()> notify, WorkerPool& pool = WorkerPool::shared());
+    ~TapeSaver();  // Finishes all queued saves
+
+    TapeSaver(const TapeSaver&) = delete;
+    TapeSaver& operator=(const TapeSaver&) = delete;
+
+    // Returns a ticket that comes back with the result of the write that
+    // covers this request, which may be a newer save of the same file
+    uint64_t save(TapeSaveRequest request);
+
+    // Saves finished since the last call, in the order they finished
+    std::vector<TapeSaveResult> takeFinished();
+
+private:
+    void run();  // Pool task: writes requests until none is queued
+
+    WorkerPool& m_pool;
+    std::function<void()> m_notify;
+    mode_t m_file_mode;  // For files that do not exist yet
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    struct Queued {
+        TapeSaveRequest request;
+        std::vector<uint64_t> tickets;  // Including those of replaced requests
+    };
+
+    std::deque<Queued> m_queue;
+    uint64_t m_next_ticket;
+    std::vector<TapeSaveResult> m_finished;
+    bool m_running;  // A pool task is scheduled or writing
+};
+
+#endif
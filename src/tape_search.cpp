@@ -0,0 +1,210 @@
+#include "tape_search.h"
+#include "tape_edit.h"
+#include "tape_format.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+// "1.000" and "12.500.000" are thousands, not decimals, when typed in a
+// search; tape lines always show more or fewer than three decimals
+bool isGroupedThousands(const std::string& text) {
+    size_t start = !text.empty() && text[0] == '-' ? 1 : 0;
+    size_t groups = 0;
+    size_t group_size = 0;
+    for (size_t i = start; i <= text.size(); i++) {
+        if (i == text.size() || text[i] == '.') {
+            // First group has one to three digits, the others exactly three
+            if (group_size == 0 || group_size > 3 || (groups > 0 && group_size != 3)) {
+                return false;
+            }
+            groups++;
+            group_size = 0;
+        } else if (std::isdigit(static_cast<unsigned char>(text[i]))) {
+            group_size++;
+        } else {
+            return false;
+        }
+    }
+    return groups > 1;
+}
+
+bool parseSearchNumber(const std::string& text, double& value) {
+    std::string number = trim(text);
+    if (number.find(',') == std::string::npos && isGroupedThousands(number)) {
+        number.erase(std::remove(number.begin(), number.end(), '.'), number.end());
+    }
+    return parseTapeNumber(number, value);
+}
+
+TapeQuery::Kind kindOf(const TapeEntry& entry, char display_operation) {
+    if (entry.is_vat_operation) {
+        return TapeQuery::Kind::Vat;
+    }
+    if (entry.operation == '=') {
+        return TapeQuery::Kind::Result;
+    }
+    if (entry.operation == 'S') {
+        return TapeQuery::Kind::Subtotal;
+    }
+    switch (display_operation) {
+        case '+': return TapeQuery::Kind::Add;
+        case '-': return TapeQuery::Kind::Subtract;
+        case '*': return TapeQuery::Kind::Multiply;
+        case '/': return TapeQuery::Kind::Divide;
+    }
+    return TapeQuery::Kind::Any;
+}
+
+}  // namespace
+
+bool parseTapeQuery(const std::string& text, int decimal_places, TapeQuery& query) {
+    query = TapeQuery();
+    std::string rest = trim(text);
+    if (rest.empty()) {
+        return false;
+    }
+
+    // Optional kind prefix. A '-' directly followed by a digit is a sign.
+    std::string upper = rest;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+    size_t prefix = 0;
+    if (upper.rfind("VAT", 0) == 0) {
+        query.kind = TapeQuery::Kind::Vat;
+        prefix = 3;
+    } else if (upper.rfind("ST", 0) == 0) {
+        query.kind = TapeQuery::Kind::Subtotal;
+        prefix = 2;
+    } else if (rest[0] == '=') {
+        query.kind = TapeQuery::Kind::Result;
+        prefix = 1;
+    } else if (rest[0] == '+' || rest[0] == '*' || rest[0] == '/' ||
+               (rest[0] == '-' && (rest.size() == 1 || !std::isdigit(static_cast<unsigned char>(rest[1]))))) {
+        switch (rest[0]) {
+            case '+': query.kind = TapeQuery::Kind::Add; break;
+            case '-': query.kind = TapeQuery::Kind::Subtract; break;
+            case '*': query.kind = TapeQuery::Kind::Multiply; break;
+            case '/': query.kind = TapeQuery::Kind::Divide; break;
+        }
+        prefix = 1;
+    }
+    rest = trim(rest.substr(prefix));
+    if (rest.empty()) {
+        return query.kind != TapeQuery::Kind::Any;
+    }
+
+    // Amount or range
+    std::string low_text = rest;
+    std::string high_text = rest;
+    size_t separator = rest.find("..");
+    size_t separator_size = 2;
+    if (separator == std::string::npos) {
+        separator = rest.find(" - ");
+        separator_size = 3;
+    }
+    if (separator != std::string::npos) {
+        low_text = rest.substr(0, separator);
+        high_text = rest.substr(separator + separator_size);
+    }
+
+    double low = 0.0;
+    double high = 0.0;
+    if (!parseSearchNumber(low_text, low) || !parseSearchNumber(high_text, high)) {
+        return false;
+    }
+    if (low > high) {
+        std::swap(low, high);
+    }
+
+    // Anything that rounds to the typed amount matches
+    double tolerance = 0.5 * std::pow(10.0, -decimal_places);
+    query.has_range = true;
+    query.low = low - tolerance;
+    query.high = high + tolerance;
+    return true;
+}
+
+TapeSearchIndex::TapeSearchIndex()
+    : m_lineage(0)
+    , m_version(0)
+{
+}
+
+void TapeSearchIndex::truncate(size_t size) {
+    for (size_t i = size; i < m_lines.size(); i++) {
+        if (m_lines[i].indexed) {
+            m_by_value.erase({m_lines[i].value, i});
+        }
+    }
+    m_lines.resize(std::min(size, m_lines.size()));
+
+    // Kind lists are in line order, so removed lines are at their ends
+    for (auto& lines : m_by_kind) {
+        while (!lines.empty() && lines.back() >= size) {
+            lines.pop_back();
+        }
+    }
+}
+
+void TapeSearchIndex::update(const Tape& tape) {
+    size_t first = 0;
+    if (tape.lineage() == m_lineage) {
+        first = tape.firstChangedSince(m_version);
+        if (first == SIZE_MAX) {
+            return;
+        }
+    }
+    first = std::min(first, m_lines.size());
+    truncate(first);
+
+    char operation = displayOperationAt(tape, first);
+    size_t index = first;
+    for (auto it = Tape::const_iterator(&tape, first); it != tape.end(); ++it, ++index) {
+        const TapeEntry& entry = *it;
+        IndexedLine line{0.0, TapeQuery::Kind::Any, !entry.is_separator};
+        if (line.indexed) {
+            line.value = entry.is_vat_operation ? entry.vat_amount : entry.value;
+            line.kind = kindOf(entry, operation);
+            m_by_value.insert({line.value, index});
+            if (line.kind != TapeQuery::Kind::Any) {
+                m_by_kind[static_cast<size_t>(line.kind)].push_back(index);
+            }
+        }
+        m_lines.push_back(line);
+        operation = advanceDisplayOperation(operation, entry);
+    }
+
+    m_lineage = tape.lineage();
+    m_version = tape.version();
+}
+
+std::vector<size_t> TapeSearchIndex::find(const TapeQuery& query) const {
+    std::vector<size_t> matches;
+
+    if (!query.has_range) {
+        if (query.kind != TapeQuery::Kind::Any) {
+            matches = m_by_kind[static_cast<size_t>(query.kind)];
+        }
+        return matches;
+    }
+
+    auto it = m_by_value.lower_bound({query.low, 0});
+    auto end = m_by_value.upper_bound({query.high, SIZE_MAX});
+    for (; it != end; ++it) {
+        if (query.kind == TapeQuery::Kind::Any || m_lines[it->second].kind == query.kind) {
+            matches.push_back(it->second);
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
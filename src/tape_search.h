@@ -0,0 +1,61 @@
+#ifndef TAPE_SEARCH_H
+#define TAPE_SEARCH_H
+
+#include "tape.h"
+#include <array>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What the tape search bar looks for: a kind of line, a value range, or both
+struct TapeQuery {
+    enum class Kind : uint8_t { Any, Add, Subtract, Multiply, Divide, Result, Subtotal, Vat };
+
+    Kind kind = Kind::Any;
+    bool has_range = false;
+    double low = 0.0;
+    double high = 0.0;
+};
+
+// Accepts an amount ("149,90", "1.000"), a range ("1.000..2.000" or
+// "1000 - 2000"), a kind ("VAT", "=", "ST", "+", "-", "*", "/") or a kind
+// followed by an amount or range ("= 100..200"). Single amounts match
+// everything that looks the same at decimal_places.
+bool parseTapeQuery(const std::string& text, int decimal_places, TapeQuery& query);
+
+// Sorted index over the values and line kinds of a tape.
+//
+// update() follows the tape's change log, so appending a line or undoing
+// one re-indexes only the lines from the first change on. Value searches
+// are a range scan of an ordered set, O(log n + k); kind searches read a
+// per-kind list of line indices.
+class TapeSearchIndex {
+public:
+    TapeSearchIndex();
+
+    void update(const Tape& tape);
+
+    // Indices of the matching tape lines, in tape order
+    std::vector<size_t> find(const TapeQuery& query) const;
+
+private:
+    static constexpr size_t KIND_COUNT = 8;
+
+    struct IndexedLine {
+        double value;
+        TapeQuery::Kind kind;
+        bool indexed;  // Separators are not searchable
+    };
+
+    void truncate(size_t size);
+
+    uint64_t m_lineage;
+    uint64_t m_version;
+    std::vector<IndexedLine> m_lines;
+    std::set<std::pair<double, size_t>> m_by_value;
+    std::array<std::vector<size_t>, KIND_COUNT> m_by_kind;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "tape_widget.h"
+#include <algorithm>
+#include <cmath>
+
+TapeWidget::TapeWidget()
+    : Glib::ObjectBase("TapeWidget")
+    , Gtk::Widget()
+    , m_vadjustment(Gtk::Adjustment::create(0.0, 0.0, 0.0))
+    , m_search_current(0)
+    , m_row_height(0)
+    , m_line_width(0)
+    , m_font_serial(0)
+{
+    set_overflow(Gtk::Overflow::HIDDEN);
+    add_css_class("tape-canvas");
+
+    m_vadjustment->signal_value_changed().connect([this]() {
+        queue_draw();
+    });
+
+    auto scroll_controller = Gtk::EventControllerScroll::create();
+    scroll_controller->set_flags(Gtk::EventControllerScroll::Flags::VERTICAL);
+    scroll_controller->signal_scroll().connect(sigc::mem_fun(*this, &TapeWidget::on_scroll), false);
+    add_controller(scroll_controller);
+}
+
+TapeWidget::~TapeWidget() {
+    m_items_changed_connection.disconnect();
+}
+
+void TapeWidget::set_model(const Glib::RefPtr<TapeListModel>& model) {
+    m_items_changed_connection.disconnect();
+    m_model = model;
+    m_rows.clear();
+
+    if (m_model) {
+        m_items_changed_connection = m_model->signal_items_changed().connect(
+            sigc::mem_fun(*this, &TapeWidget::on_items_changed));
+    }
+    queue_resize();
+}
+
+void TapeWidget::on_items_changed(guint position, guint /*removed*/, guint /*added*/) {
+    // Rows from position onwards changed or moved; the rest stay cached
+    for (auto it = m_rows.begin(); it != m_rows.end();) {
+        if (it->first >= position) {
+            it = m_rows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    update_adjustment();
+    queue_draw();
+}
+
+bool TapeWidget::on_scroll(double /*dx*/, double dy) {
+    ensure_metrics();
+    double value = m_vadjustment->get_value() + dy * m_row_height * 3;
+    m_vadjustment->set_value(std::clamp(value, m_vadjustment->get_lower(),
+                                        m_vadjustment->get_upper() - m_vadjustment->get_page_size()));
+    return true;
+}
+
+void TapeWidget::ensure_metrics() const {
+    // GTK updates the widget's Pango context when a CSS change (a theme,
+    // a font setting, a style class) touches the font; metrics and row
+    // layouts made with the old font are stale then
+    guint serial = const_cast<TapeWidget*>(this)->get_pango_context()->get_serial();
+    if (m_row_height > 0 && serial == m_font_serial) {
+        return;
+    }
+    m_font_serial = serial;
+    m_rows.clear();
+
+    // Widest formatted line: a group summary, "op" + 13 columns for the
+    // amount and the line count
+    auto layout = const_cast<TapeWidget*>(this)->create_pango_layout("ST 000000000000000  \u25B8 00000 lines");
+    int width = 0;
+    int height = 0;
+    layout->get_pixel_size(width, height);
+    m_row_height = std::max(height, 1);
+    m_line_width = width;
+}
+
+void TapeWidget::update_adjustment() {
+    ensure_metrics();
+    guint rows = m_model ? m_model->get_n_items() : 0;
+    double page = get_height();
+    double upper = std::max(static_cast<double>(rows) * m_row_height + 2 * PADDING_Y, page);
+    double value = std::clamp(m_vadjustment->get_value(), 0.0, upper - page);
+    m_vadjustment->configure(value, 0.0, upper, m_row_height, page * 0.9, page);
+}
+
+int TapeWidget::get_row_at_y(double y) const {
+    if (!m_model || m_row_height <= 0) {
+        return -1;
+    }
+
+    double offset = y + m_vadjustment->get_value() - PADDING_Y;
+    if (offset < 0) {
+        return -1;
+    }
+    guint row = static_cast<guint>(offset / m_row_height);
+    return row < m_model->get_n_items() ? static_cast<int>(row) : -1;
+}
+
+void TapeWidget::set_search_matches(std::vector<size_t> lines, size_t current) {
+    m_search_matches = std::move(lines);
+    m_search_current = current;
+    queue_draw();
+}
+
+void TapeWidget::scroll_to_row(guint row) {
+    ensure_metrics();
+
+    // Centre the row
+    double y = PADDING_Y + static_cast<double>(row) * m_row_height;
+    double page = m_vadjustment->get_page_size();
+    double value = y - (page - m_row_height) / 2;
+    m_vadjustment->set_value(std::clamp(value, m_vadjustment->get_lower(),
+                                        std::max(0.0, m_vadjustment->get_upper() - page)));
+}
+
+Gtk::SizeRequestMode TapeWidget::get_request_mode_vfunc() const {
+    return Gtk::SizeRequestMode::CONSTANT_SIZE;
+}
+
+void TapeWidget::measure_vfunc(Gtk::Orientation orientation, int /*for_size*/, int& minimum, int& natural,
+                               int& minimum_baseline, int& natural_baseline) const {
+    ensure_metrics();
+    if (orientation == Gtk::Orientation::HORIZONTAL) {
+        minimum = m_line_width + 2 * PADDING_X;
+        natural = minimum;
+    } else {
+        // Scrolls itself, so it only asks for a few rows
+        minimum = m_row_height * 3 + 2 * PADDING_Y;
+        natural = minimum;
+    }
+    minimum_baseline = -1;
+    natural_baseline = -1;
+}
+
+void TapeWidget::size_allocate_vfunc(int /*width*/, int /*height*/, int /*baseline*/) {
+    update_adjustment();
+}
+
+const TapeWidget::CachedRow& TapeWidget::get_row(guint position) {
+    auto it = m_rows.find(position);
+    if (it == m_rows.end()) {
+        TapeLine line = m_model->get_line(position);
+        it = m_rows.emplace(position, CachedRow{create_pango_layout(line.text), line.highlight}).first;
+    }
+    return it->second;
+}
+
+void TapeWidget::snapshot_vfunc(const Glib::RefPtr<Gtk::Snapshot>& snapshot) {
+    if (!m_model) {
+        return;
+    }
+    ensure_metrics();
+
+    guint rows = m_model->get_n_items();
+    double scroll = m_vadjustment->get_value();
+    double top = scroll - PADDING_Y;
+    guint first = static_cast<guint>(std::max(0.0, std::floor(top / m_row_height)));
+    guint last = static_cast<guint>(std::max(0.0, std::ceil((top + get_height()) / m_row_height)));
+    last = std::min(last, rows);
+
+    // Only the visible window stays cached
+    for (auto it = m_rows.begin(); it != m_rows.end();) {
+        if (it->first < first || it->first >= last) {
+            it = m_rows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Gdk::RGBA foreground = get_color();
+    Gdk::RGBA highlight("#D86A35");
+    Gdk::RGBA match("rgba(255, 200, 0, 0.25)");
+    Gdk::RGBA current_match("rgba(255, 200, 0, 0.6)");
+
+    for (guint row = first; row < last; row++) {
+        const CachedRow& cached = get_row(row);
+        float y = static_cast<float>(PADDING_Y + static_cast<double>(row) * m_row_height - scroll);
+
+        // Matches on the lines behind the row, found by binary search
+        if (!m_search_matches.empty() && m_model->is_history_row(row)) {
+            TapeRowRef lines = m_model->get_row(row);
+            auto found = std::lower_bound(m_search_matches.begin(), m_search_matches.end(), lines.first_line);
+            if (found != m_search_matches.end() && *found <= lines.line) {
+                size_t current = m_search_current < m_search_matches.size() ? m_search_matches[m_search_current] : SIZE_MAX;
+                bool is_current = current >= lines.first_line && current <= lines.line;
+                snapshot->append_color(is_current ? current_match : match,
+                                       Gdk::Graphene::Rect(0, y, get_width(), m_row_height));
+            }
+        }
+
+        snapshot->save();
+        snapshot->translate(Gdk::Graphene::Point(PADDING_X, y));
+        snapshot->append_layout(cached.layout, cached.highlight ? highlight : foreground);
+        snapshot->restore();
+    }
+}
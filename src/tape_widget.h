@@ -0,0 +1,69 @@
+#ifndef TAPE_WIDGET_H
+#define TAPE_WIDGET_H
+
+#include "tape_list_model.h"
+#include <gtkmm.h>
+#include <unordered_map>
+#include <vector>
+
+// Read-only tape drawn directly with GtkSnapshot.
+//
+// Only the rows inside the visible window are drawn. Each row's Pango layout
+// is cached until the model reports that row as changed, so appending a line
+// or typing a digit re-lays out just the last row; scrolling reuses the
+// cached layouts. The colour comes from the formatted line instead of text
+// tags. Scrolling is driven by the vertical adjustment, which can be shared
+// with a Gtk::Scrollbar.
+class TapeWidget : public Gtk::Widget {
+public:
+    TapeWidget();
+    ~TapeWidget() override;
+
+    void set_model(const Glib::RefPtr<TapeListModel>& model);
+    Glib::RefPtr<Gtk::Adjustment> get_vadjustment() { return m_vadjustment; }
+
+    // Row under a widget y coordinate, or -1 if there is none
+    int get_row_at_y(double y) const;
+
+    // Search matches (sorted tape lines) are marked on the rows showing
+    // them when those rows are drawn
+    void set_search_matches(std::vector<size_t> lines, size_t current);
+    void scroll_to_row(guint row);
+
+protected:
+    Gtk::SizeRequestMode get_request_mode_vfunc() const override;
+    void measure_vfunc(Gtk::Orientation orientation, int for_size, int& minimum, int& natural,
+                       int& minimum_baseline, int& natural_baseline) const override;
+    void size_allocate_vfunc(int width, int height, int baseline) override;
+    void snapshot_vfunc(const Glib::RefPtr<Gtk::Snapshot>& snapshot) override;
+
+private:
+    static constexpr int PADDING_X = 20;
+    static constexpr int PADDING_Y = 10;
+
+    struct CachedRow {
+        Glib::RefPtr<Pango::Layout> layout;
+        bool highlight;
+    };
+
+    void on_items_changed(guint position, guint removed, guint added);
+    bool on_scroll(double dx, double dy);
+    void update_adjustment();
+    void ensure_metrics() const;
+    const CachedRow& get_row(guint position);
+
+    Glib::RefPtr<TapeListModel> m_model;
+    sigc::connection m_items_changed_connection;
+    Glib::RefPtr<Gtk::Adjustment> m_vadjustment;
+    mutable std::unordered_map<guint, CachedRow> m_rows;  // Dropped with the metrics
+    std::vector<size_t> m_search_matches;
+    size_t m_search_current;  // Index into m_search_matches
+
+    // Font metrics, measured from the widget's CSS font on first use and
+    // again whenever the font changes (the Pango context serial moves on)
+    mutable int m_row_height;
+    mutable int m_line_width;
+    mutable guint m_font_serial;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef UI_STATE_H
+#define UI_STATE_H
+
+// The value last pushed to a widget or action. update() reports whether the
+// new value differs, so callers only touch widgets whose state changed.
+template <typename T>
+class Tracked {
+public:
+    // Returns true if value differs from the last one (or none was set yet)
+    bool update(const T& value) {
+        if (m_valid && m_value == value) {
+            return false;
+        }
+        m_value = value;
+        m_valid = true;
+        return true;
+    }
+
+    // Forces the next update() to report a change
+    void invalidate() { m_valid = false; }
+
+private:
+    T m_value{};
+    bool m_valid = false;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+WorkerPool::WorkerPool(unsigned threads)
+    : m_stop(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+std::future<void> WorkerPool::submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> done = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(packaged));
+    }
+    m_wake.notify_one();
+    return done;
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // Helpers that start after every item is taken return without touching
+    // body, so only the counters need to outlive this call
+    struct Progress {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto progress = std::make_shared<Progress>();
+    auto work = [progress, &body, count]() {
+        for (size_t i = progress->next.fetch_add(1); i < count; i = progress->next.fetch_add(1)) {
+            body(i);
+            if (progress->done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(progress->mutex);
+                progress->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(size(), count) - 1;
+    for (size_t i = 0; i < helpers; i++) {
+        submit(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(progress->mutex);
+    progress->finished.wait(lock, [&progress, count]() { return progress->done.load() == count; });
+}
+
+void WorkerPool::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_wake.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+            break;  // Stopping and nothing left to do
+        }
+
+        std::packaged_task<void()> task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
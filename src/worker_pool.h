@@ -0,0 +1,47 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of background threads shared by every window and tab.
+//
+// Loading, re-evaluating and exporting tapes all queue their work here, so
+// the number of threads stays bounded by the core count no matter how many
+// tapes are open.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads = 0);  // 0 = one per core
+    ~WorkerPool();  // Finishes queued tasks
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    static WorkerPool& shared();
+
+    unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+    std::future<void> submit(std::function<void()> task);
+
+    // Calls body(i) for every i below count, spread over the pool, and
+    // returns when all calls are done. The calling thread takes items too,
+    // so this may be used from inside a pool task. body must not throw.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::packaged_task<void()>> m_tasks;
+    bool m_stop;
+    std::vector<std::thread> m_threads;
+};
+
+#endif